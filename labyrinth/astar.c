@@ -0,0 +1,107 @@
+#include "astar.h"
+#include "bitset.h"
+#include "utils.h"
+#include "vector.h"
+
+// Number of buckets of the queue. A step changes distance from start by 1
+// and the heuristic by 1 or -1, so estimated length of a path through
+// a neighbour is the same as through the current position or larger
+// by 2. Only buckets of the smallest estimate and the one 2 above it
+// can be non-empty.
+#define BUCKETS_NUMBER 2
+
+// Bucket queue of position hashes. Bucket i holds positions with
+// estimated path length estimate + 2 * i. Every bucket is a stack, so
+// among positions with the same estimate the most recent, i.e. the
+// furthest from start, is expanded first.
+typedef struct {
+  Vector *buckets[BUCKETS_NUMBER];
+  size_t estimate;
+} Queue;
+
+// Removes position with the smallest estimate from queue and returns its
+// hash. Returns false if queue is empty.
+static bool queue_pop(Queue *queue, size_t *position_hash) {
+  if (vector_is_empty(queue->buckets[0])) {
+    if (vector_is_empty(queue->buckets[1])) {
+      return false;
+    }
+
+    swap((void **)&queue->buckets[0], (void **)&queue->buckets[1]);
+    queue->estimate += 2;
+  }
+
+  *position_hash = vector_pop_back(queue->buckets[0]);
+
+  return true;
+}
+
+// Returns distance between position and end position, i.e. the sum of
+// their coordinate differences.
+static uint64_t distance(Vector *position, Vector *end_position) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < vector_size(position); i++) {
+    uint64_t z_i = vector_get(position, i), e_i = vector_get(end_position, i);
+    result += z_i > e_i ? z_i - e_i : e_i - z_i;
+  }
+
+  return result;
+}
+
+size_t astar_find_shortest_path(Maze *maze) {
+  Bitset *walls = maze_walls(maze);
+  Bitset *visited = maze_visited(maze, maze_size(maze));
+  size_t end_position_hash = maze_end_position_hash(maze);
+  size_t answer = 0;
+
+  // will store coordinates of current and end position
+  Vector *position = vector_create();
+  Vector *end_position = vector_create();
+  maze_position(maze, end_position_hash, end_position);
+  maze_position(maze, maze_start_position_hash(maze), position);
+
+  // initialize search using start position
+  Queue queue = {{vector_create(), vector_create()},
+                 distance(position, end_position)};
+  vector_push_back(queue.buckets[0], maze_start_position_hash(maze));
+
+  size_t position_hash;
+  while (queue_pop(&queue, &position_hash)) {
+    // position may be pushed many times before it's expanded, but the
+    // first time it's popped, its distance from start is the smallest
+    if (bitset_get(visited, position_hash)) {
+      continue;
+    }
+    if (position_hash == end_position_hash) {
+      answer = queue.estimate;
+      break;
+    }
+    bitset_set(visited, position_hash);
+    maze_position(maze, position_hash, position);
+
+    size_t N = 1;
+    for (size_t i = 0; i < vector_size(position); i++) {
+      uint64_t z_i = vector_get(position, i), e_i = vector_get(end_position, i);
+
+      // decrementing i-th coordinate gets closer to end if z_i > e_i
+      if (z_i > 1 && !bitset_get(walls, position_hash - N) &&
+          !bitset_get(visited, position_hash - N)) {
+        vector_push_back(queue.buckets[z_i <= e_i], position_hash - N);
+      }
+      if (z_i < maze_dimension(maze, i) &&
+          !bitset_get(walls, position_hash + N) &&
+          !bitset_get(visited, position_hash + N)) {
+        vector_push_back(queue.buckets[z_i >= e_i], position_hash + N);
+      }
+
+      N *= maze_dimension(maze, i);
+    }
+  }
+
+  vector_free(queue.buckets[0]);
+  vector_free(queue.buckets[1]);
+  vector_free(position);
+  vector_free(end_position);
+
+  return answer;
+}
@@ -0,0 +1,16 @@
+#ifndef ASTAR_H
+#define ASTAR_H
+
+#include <stddef.h>
+#include "maze.h"
+
+// Finds length of the shortest path from start to end position using A*
+// search with the sum of coordinate differences to end position as the
+// heuristic. Positions are kept in buckets indexed by their estimated
+// path length. Returns 0 if the path doesn't exist. Keeps visited
+// positions apart from walls in the visited bitset of maze, whose pages
+// are committed only where the search goes. Assumes that start and end
+// positions are not equal.
+size_t astar_find_shortest_path(Maze *maze);
+
+#endif  // ASTAR_H
@@ -0,0 +1,268 @@
+#include "batch.h"
+#include <stdio.h>
+#include <string.h>
+#include "bitset.h"
+#include "grid.h"
+#include "stats.h"
+#include "utils.h"
+
+// Number of queries answered by one traversal.
+#define GROUP_SIZE 64
+
+#define BITS 64
+
+// Answer of a query without a path.
+#define NO_WAY SIZE_MAX
+
+// Words of a free position. The i-th query of the group owns the i-th bit
+// of every word. They're kept together, so that a visit of the position
+// touches a single cache line.
+typedef struct {
+  // queries which reached the position
+  uint64_t seen;
+  // queries for which the position belongs to a level, visit[depth % 2]
+  // for the current level and the other word for the next one
+  uint64_t visit[2];
+} Visits;
+
+// State of a traversal shared by a group of queries. Visits are kept for
+// free positions only, the free position with hash p at index
+// free_index(p).
+typedef struct {
+  Maze *maze;
+  // grid used for neighbour offsets or NULL, if maze is searched directly
+  Grid *grid;
+  ptrdiff_t *offsets;
+  Bitset *walls;
+  uint64_t *wall_words;
+  // number of free positions in words before every word of walls, which
+  // fits in 32 bits, as mazes with at least GRID_SIZE_MAX positions aren't
+  // traversed
+  uint32_t *ranks;
+  size_t free_number;
+
+  Visits *visits;
+  // positions of current and next level
+  Vector *current_depth_positions;
+  Vector *next_depth_positions;
+} Traversal;
+
+// Saves hashes of positions adjacent to given one to neighbours and returns
+// their number.
+static size_t find_neighbours(Traversal *traversal, size_t position_hash,
+                              size_t *neighbours) {
+  size_t neighbours_number = 0;
+
+  if (traversal->grid != NULL) {
+    for (size_t j = 0; j < 2 * traversal->grid->dimensions_number; j++) {
+      neighbours[neighbours_number++] =
+          position_hash + traversal->offsets[j];
+    }
+
+    return neighbours_number;
+  }
+
+  return maze_neighbours(traversal->maze, position_hash, neighbours);
+}
+
+// Returns index of words of position with given hash, which is free.
+static size_t free_index(Traversal *traversal, size_t position_hash) {
+  size_t w = position_hash / BITS;
+  uint64_t below = (1ULL << (position_hash % BITS)) - 1;
+
+  return traversal->ranks[w] +
+         (size_t)__builtin_popcountll(~traversal->wall_words[w] & below);
+}
+
+// Counts free positions before every word of walls.
+static void rank_free_positions(Traversal *traversal) {
+  uint64_t *walls = traversal->wall_words;
+  size_t words_number = bitset_words_number(traversal->walls);
+  traversal->ranks = (uint32_t *)safe_calloc(words_number, sizeof(uint32_t));
+
+  size_t free_number = 0;
+  for (size_t w = 0; w < words_number; w++) {
+    traversal->ranks[w] = (uint32_t)free_number;
+    free_number += (size_t)__builtin_popcountll(~walls[w]);
+  }
+  traversal->free_number = free_number;
+}
+
+// Returns hash of maze position in the searched space.
+static size_t traversal_hash(Traversal *traversal, size_t position_hash) {
+  return traversal->grid != NULL
+             ? grid_position_hash(traversal->grid, traversal->maze,
+                                  position_hash)
+             : position_hash;
+}
+
+// Answers queries [first, first + n) and saves the answers.
+static void solve_group(Traversal *traversal, Vector *queries, size_t first,
+                        size_t n, size_t *answers) {
+  // indexes of end positions
+  size_t *ends = (size_t *)safe_calloc(n, sizeof(size_t));
+  size_t *neighbours = (size_t *)safe_calloc(
+      2 * maze_dimensions_number(traversal->maze), sizeof(size_t));
+  uint64_t unanswered = 0;
+
+  // initialize bfs using start positions
+  for (size_t q = 0; q < n; q++) {
+    size_t maze_start = vector_get(queries, 2 * first);
+    size_t maze_end = vector_get(queries, 2 * first + 1);
+    size_t start = traversal_hash(traversal, maze_start);
+    size_t start_index = free_index(traversal, start);
+    ends[q] = free_index(traversal, traversal_hash(traversal, maze_end));
+    ++first;
+
+    if (start_index == ends[q]) {
+      answers[q] = 0;
+      continue;
+    } else if (!maze_may_be_connected(traversal->maze, maze_start, maze_end)) {
+      answers[q] = NO_WAY;
+      continue;
+    }
+
+    answers[q] = NO_WAY;
+    unanswered |= 1ULL << q;
+    Visits *visits = &traversal->visits[start_index];
+    if (visits->visit[0] == 0) {
+      vector_push_back(traversal->current_depth_positions, start);
+      vector_push_back(traversal->current_depth_positions, start_index);
+    }
+    visits->visit[0] |= 1ULL << q;
+    visits->seen |= 1ULL << q;
+  }
+
+  size_t depth = 0;
+  while (unanswered != 0 &&
+         !vector_is_empty(traversal->current_depth_positions)) {
+    while (!vector_is_empty(traversal->current_depth_positions)) {
+      size_t position_index =
+          vector_pop_back(traversal->current_depth_positions);
+      size_t position_hash =
+          vector_pop_back(traversal->current_depth_positions);
+      Visits *visits = &traversal->visits[position_index];
+      uint64_t visit = visits->visit[depth % 2] & unanswered;
+      visits->visit[depth % 2] = 0;
+      if (visit == 0) {
+        continue;
+      }
+
+      size_t neighbours_number =
+          find_neighbours(traversal, position_hash, neighbours);
+      for (size_t j = 0; j < neighbours_number; j++) {
+        size_t next = neighbours[j];
+        if (traversal->wall_words[next / BITS] >> (next % BITS) & 1) {
+          continue;
+        }
+
+        // free neighbours next to position in the order of hashes are next
+        // to it in the order of indexes too
+        size_t next_index = next == position_hash + 1 ? position_index + 1
+                            : next + 1 == position_hash
+                                ? position_index - 1
+                                : free_index(traversal, next);
+        Visits *next_visits = &traversal->visits[next_index];
+        uint64_t reached = visit & ~next_visits->seen;
+        if (reached == 0) {
+          continue;
+        }
+
+        if (next_visits->visit[(depth + 1) % 2] == 0) {
+          vector_push_back(traversal->next_depth_positions, next);
+          vector_push_back(traversal->next_depth_positions, next_index);
+        }
+        next_visits->visit[(depth + 1) % 2] |= reached;
+        next_visits->seen |= reached;
+      }
+    }
+
+    ++depth;
+    for (size_t q = 0; q < n; q++) {
+      uint64_t seen = traversal->visits[ends[q]].seen;
+      if ((unanswered >> q & 1) && (seen >> q & 1)) {
+        answers[q] = depth;
+        unanswered &= ~(1ULL << q);
+      }
+    }
+
+    swap((void **)&traversal->current_depth_positions,
+         (void **)&traversal->next_depth_positions);
+  }
+
+  // prepare traversal for the next group
+  vector_clear(traversal->current_depth_positions);
+  memset(traversal->visits, 0, traversal->free_number * sizeof(Visits));
+
+  free(ends);
+  free(neighbours);
+}
+
+// Prints answer of a query.
+static void print_answer(size_t answer) {
+  if (answer != NO_WAY) {
+    printf("%zu\n", answer);
+  } else {
+    printf("NO WAY\n");
+  }
+}
+
+// Answers every query with a separate search of the selected solver,
+// which needs memory only for the positions it visits.
+static void solve_separately(Maze *maze, Vector *queries) {
+  for (size_t i = 0; i + 1 < vector_size(queries); i += 2) {
+    print_answer(maze_path_length(maze, vector_get(queries, i),
+                                  vector_get(queries, i + 1)));
+  }
+}
+
+void batch_solve(Maze *maze, Vector *queries) {
+  stats_start(PHASE_SEARCH);
+
+  if (maze_size(maze) >= GRID_SIZE_MAX) {
+    // visits of all free positions would take far more memory than walls
+    solve_separately(maze, queries);
+    stats_stop(PHASE_SEARCH);
+    return;
+  }
+
+  Traversal traversal = {0};
+  traversal.maze = maze;
+  traversal.grid = grid_create(maze);
+  if (traversal.grid != NULL) {
+    traversal.offsets = (ptrdiff_t *)safe_calloc(
+        2 * traversal.grid->dimensions_number, sizeof(ptrdiff_t));
+    grid_neighbour_offsets(traversal.grid, traversal.offsets);
+    traversal.walls = traversal.grid->walls;
+  } else {
+    traversal.walls = maze_walls(maze);
+  }
+
+  traversal.wall_words = bitset_data(traversal.walls);
+  rank_free_positions(&traversal);
+  traversal.visits =
+      (Visits *)safe_calloc(traversal.free_number, sizeof(Visits));
+  traversal.current_depth_positions = vector_create();
+  traversal.next_depth_positions = vector_create();
+
+  size_t queries_number = vector_size(queries) / 2;
+  size_t answers[GROUP_SIZE];
+  for (size_t first = 0; first < queries_number; first += GROUP_SIZE) {
+    size_t n = queries_number - first < GROUP_SIZE ? queries_number - first
+                                                   : GROUP_SIZE;
+    solve_group(&traversal, queries, first, n, answers);
+
+    for (size_t q = 0; q < n; q++) {
+      print_answer(answers[q]);
+    }
+  }
+
+  grid_free(traversal.grid);
+  free(traversal.offsets);
+  free(traversal.ranks);
+  free(traversal.visits);
+  vector_free(traversal.current_depth_positions);
+  vector_free(traversal.next_depth_positions);
+
+  stats_stop(PHASE_SEARCH);
+}
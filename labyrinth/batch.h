@@ -0,0 +1,16 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "maze.h"
+#include "vector.h"
+
+// Answers queries about the shortest paths in maze. Queries vector holds
+// hashes of start and end position of every query, one after another.
+// Prints the answer to every query in a separate line, in the same format
+// as maze_solve. Groups of up to 64 queries are answered by a single
+// traversal, which keeps three 64-bit words for every free position.
+// Mazes with at least 2^32 positions are searched separately for every
+// query instead. Doesn't modify maze walls.
+void batch_solve(Maze *maze, Vector *queries);
+
+#endif  // BATCH_H
@@ -0,0 +1,152 @@
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../input.h"
+#include "../maze.h"
+#include "../stats.h"
+#include "maze_generator.h"
+
+// Maze solved by the benchmark.
+typedef struct {
+  const char *name;
+  MazeDescription description;
+} Scenario;
+
+static const Scenario scenarios[] = {
+    {"2d-sparse", {2, {3000, 3000}, 0.1, 1, false, false}},
+    {"2d-dense", {2, {3000, 3000}, 0.35, 2, false, false}},
+    {"2d-no-way", {2, {3000, 3000}, 0.2, 3, false, true}},
+    {"2d-long", {2, {1000000, 4}, 0.2, 4, false, false}},
+    {"3d", {3, {200, 200, 200}, 0.3, 5, false, false}},
+    {"3d-no-way", {3, {200, 200, 200}, 0.3, 6, false, true}},
+    {"4d", {4, {50, 50, 50, 50}, 0.3, 7, false, false}},
+    {"6d", {6, {12, 12, 12, 12, 12, 12}, 0.3, 8, false, false}},
+    {"20d", {20, {2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2},
+             0.3, 9, false, false}},
+    {"2d-generator", {2, {10000, 10000}, 0.2, 10, true, false}},
+    {"3d-generator", {3, {400, 400, 400}, 0.2, 11, true, false}},
+    {"2d-generator-large", {2, {15000, 15000}, 0.05, 12, true, false}},
+};
+
+// Measurements of one scenario.
+typedef struct {
+  char answer[32];
+  double seconds[PHASES_NUMBER];
+  // number of positions expanded by the search
+  size_t expanded;
+  // peak resident set size in KiB
+  long max_rss;
+} Result;
+
+// Solves maze from input like the labyrinth program and writes time of
+// every phase and number of expanded positions to fd. Runs in a child
+// process.
+static void solve(int fd) {
+  stats_enable();
+  Maze *maze = maze_create();
+  if (read_maze_data(maze)) {
+    maze_solve(maze);
+  }
+  maze_free(maze);
+  fflush(stdout);
+
+  double seconds[PHASES_NUMBER];
+  for (int phase = 0; phase < PHASES_NUMBER; phase++) {
+    seconds[phase] = stats_seconds((Phase)phase);
+  }
+  size_t expanded = stats_expanded_positions();
+  if (write(fd, seconds, sizeof(seconds)) != (ssize_t)sizeof(seconds) ||
+      write(fd, &expanded, sizeof(expanded)) != (ssize_t)sizeof(expanded)) {
+    _exit(1);
+  }
+
+  _exit(0);
+}
+
+// Runs scenario in a child process, so that its memory is measured
+// separately. Returns false if it failed.
+static bool run(const Scenario *scenario, Result *result) {
+  FILE *input = tmpfile();
+  MazeDescription description = scenario->description;
+  if (input == NULL || !generate_maze(input, &description) ||
+      fflush(input) != 0) {
+    return false;
+  }
+  rewind(input);
+
+  int times[2], output[2];
+  if (pipe(times) != 0 || pipe(output) != 0) {
+    return false;
+  }
+
+  // child mustn't inherit unwritten output
+  fflush(stdout);
+  pid_t pid = fork();
+  if (pid == 0) {
+    dup2(fileno(input), STDIN_FILENO);
+    dup2(output[1], STDOUT_FILENO);
+    dup2(output[1], STDERR_FILENO);
+    close(times[0]);
+    close(output[0]);
+    solve(times[1]);
+  }
+  close(times[1]);
+  close(output[1]);
+  fclose(input);
+
+  int status;
+  struct rusage usage;
+  bool correct = pid > 0 && wait4(pid, &status, 0, &usage) == pid &&
+                 WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                 read(times[0], result->seconds, sizeof(result->seconds)) ==
+                     (ssize_t)sizeof(result->seconds) &&
+                 read(times[0], &result->expanded, sizeof(result->expanded)) ==
+                     (ssize_t)sizeof(result->expanded);
+
+  ssize_t length = read(output[0], result->answer, sizeof(result->answer) - 1);
+  result->answer[length > 0 ? length : 0] = '\0';
+  result->answer[strcspn(result->answer, "\n")] = '\0';
+  if (correct) {
+    result->max_rss = usage.ru_maxrss;
+  }
+
+  close(times[0]);
+  close(output[0]);
+
+  return correct;
+}
+
+int main(int argc, char **argv) {
+  // only scenarios whose names contain the argument are run
+  const char *filter = argc > 1 ? argv[1] : "";
+
+  printf("%-20s %10s %9s %9s %9s %11s %9s\n", "scenario", "answer", "parse",
+         "walls", "search", "Mcells/s", "RSS MiB");
+  for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+    if (strstr(scenarios[i].name, filter) == NULL) {
+      continue;
+    }
+
+    Result result = {0};
+    if (!run(&scenarios[i], &result)) {
+      printf("%-20s failed: %s\n", scenarios[i].name, result.answer);
+      continue;
+    }
+
+    double search = result.seconds[PHASE_SEARCH];
+    printf("%-20s %10s %8.3fs %8.3fs %8.3fs %11.1f %9ld\n", scenarios[i].name,
+           result.answer, result.seconds[PHASE_PARSE],
+           result.seconds[PHASE_WALLS], search,
+           search > 0 ? (double)result.expanded / search / 1e6 : 0,
+           result.max_rss / 1024);
+    fflush(stdout);
+  }
+
+  return 0;
+}
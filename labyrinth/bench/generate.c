@@ -0,0 +1,69 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "maze_generator.h"
+
+// Prints program usage to standard error.
+static void print_usage(char *program) {
+  fprintf(stderr,
+          "Usage: %s [-d density] [-s seed] [-r] [-n] dimensions...\n",
+          program);
+}
+
+// Reads program options and dimensions. Returns false if they're
+// incorrect.
+static bool read_arguments(int argc, char **argv,
+                           MazeDescription *description) {
+  int option;
+  while ((option = getopt(argc, argv, "d:s:rn")) != -1) {
+    char *end = NULL;
+    switch (option) {
+      case 'd':
+        description->density = strtod(optarg, &end);
+        if (*optarg == '\0' || *end != '\0') {
+          return false;
+        }
+        break;
+      case 's':
+        description->seed = strtoull(optarg, &end, 10);
+        if (*optarg == '\0' || *end != '\0') {
+          return false;
+        }
+        break;
+      case 'r':
+        description->generator_walls = true;
+        break;
+      case 'n':
+        description->no_way = true;
+        break;
+      default:
+        return false;
+    }
+  }
+
+  if (argc - optind > GENERATOR_DIMENSIONS_MAX) {
+    return false;
+  }
+  for (int i = optind; i < argc; i++) {
+    char *end = NULL;
+    description->dimensions[description->dimensions_number++] =
+        strtoull(argv[i], &end, 10);
+    if (*argv[i] == '\0' || *end != '\0') {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, char **argv) {
+  MazeDescription description = {.density = 0.3, .seed = 1};
+
+  if (!read_arguments(argc, argv, &description) ||
+      !generate_maze(stdout, &description)) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  return 0;
+}
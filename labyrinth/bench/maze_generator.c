@@ -0,0 +1,153 @@
+#include "maze_generator.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include "../utils.h"
+
+// Returns the next number of splitmix64 sequence.
+static uint64_t next_random(uint64_t *state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+  return z ^ (z >> 31);
+}
+
+// Returns product of dimensions or SIZE_MAX on overflow.
+static size_t maze_size(MazeDescription *description) {
+  size_t size = 1;
+  for (size_t i = 0; i < description->dimensions_number; i++) {
+    size = safe_product(size, description->dimensions[i]);
+  }
+
+  return size;
+}
+
+static void write_positions(FILE *out, MazeDescription *description) {
+  for (size_t i = 0; i < description->dimensions_number; i++) {
+    fprintf(out, i == 0 ? "%" PRIu64 : " %" PRIu64,
+            description->dimensions[i]);
+  }
+  fprintf(out, "\n");
+
+  for (size_t i = 0; i < description->dimensions_number; i++) {
+    fprintf(out, i == 0 ? "1" : " 1");
+  }
+  fprintf(out, "\n");
+
+  for (size_t i = 0; i < description->dimensions_number; i++) {
+    fprintf(out, i == 0 ? "%" PRIu64 : " %" PRIu64,
+            description->dimensions[i]);
+  }
+  fprintf(out, "\n");
+}
+
+// Writes walls as a hexadecimal number, the most significant digit first.
+static void write_hexadecimal(FILE *out, uint64_t *words, size_t size) {
+  size_t digits_number = size / 4 + 1;
+  while (digits_number > 1 &&
+         (words[(digits_number - 1) / 16] >> (digits_number - 1) % 16 * 4 &
+          0xF) == 0) {
+    --digits_number;
+  }
+
+  fprintf(out, "0x");
+  for (size_t d = digits_number; d-- > 0;) {
+    fputc("0123456789abcdef"[words[d / 16] >> d % 16 * 4 & 0xF], out);
+  }
+  fprintf(out, "\n");
+}
+
+static void generate_hexadecimal_walls(FILE *out,
+                                       MazeDescription *description,
+                                       size_t size, uint64_t *state) {
+  uint64_t *words = (uint64_t *)safe_calloc(size / 64 + 1, sizeof(uint64_t));
+  uint64_t threshold = description->density >= 1
+                           ? UINT64_MAX
+                           : (uint64_t)(description->density * 0x1p64);
+
+  for (size_t i = 0; i < size; i++) {
+    if (next_random(state) < threshold) {
+      words[i / 64] |= 1ULL << (i % 64);
+    }
+  }
+
+  // carve a path which goes along every dimension in turn
+  size_t hash = 0, stride = 1;
+  words[0] &= ~1ULL;
+  for (size_t i = 0; i < description->dimensions_number; i++) {
+    for (uint64_t z = 1; z < description->dimensions[i]; z++) {
+      hash += stride;
+      words[hash / 64] &= ~(1ULL << (hash % 64));
+    }
+    stride *= description->dimensions[i];
+  }
+
+  if (description->no_way) {
+    uint64_t n_0 = description->dimensions[0];
+    for (size_t row = 0; row < size / n_0; row++) {
+      size_t i = row * n_0 + n_0 / 2;
+      words[i / 64] |= 1ULL << (i % 64);
+    }
+  }
+
+  write_hexadecimal(out, words, size);
+  free(words);
+}
+
+// Generator walls repeat after this number of positions.
+#define GENERATOR_PERIOD (1ULL << 32)
+
+// Checks if generator a, b, m, r, s makes start or end position a wall.
+// The i-th step sets the wall s_i mod size, which, like in the program,
+// repeats every 2^32 positions, so a position is a wall if it's equal
+// to a set wall modulo 2^32.
+static bool blocks_corner(uint64_t a, uint64_t b, uint64_t m, uint64_t r,
+                          uint64_t s, size_t size) {
+  uint64_t start = 0, end = (size - 1) % GENERATOR_PERIOD;
+  for (uint64_t i = 0; i < r; i++) {
+    s = (a * s + b) % m;
+    uint64_t wall = (s < size ? s : s % size) % GENERATOR_PERIOD;
+    if (wall == start || wall == end) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void generate_generator_walls(FILE *out, MazeDescription *description,
+                                     size_t size, uint64_t *state) {
+  uint64_t m = size < UINT32_MAX ? size : UINT32_MAX;
+  double steps = description->density * (double)size;
+  uint64_t r = steps < UINT32_MAX ? (uint64_t)steps : UINT32_MAX;
+
+  // try new parameters until start and end position are free
+  uint64_t a, b, s;
+  do {
+    a = next_random(state) % m;
+    b = next_random(state) % m;
+    s = next_random(state) % m;
+  } while (blocks_corner(a, b, m, r, s, size));
+
+  fprintf(out, "R %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64
+               "\n",
+          a, b, m, r, s);
+}
+
+bool generate_maze(FILE *out, MazeDescription *description) {
+  size_t size = maze_size(description);
+  if (description->dimensions_number == 0 || size == SIZE_MAX ||
+      size < 2 || (description->no_way && description->dimensions[0] < 3)) {
+    return false;
+  }
+
+  uint64_t state = description->seed;
+  write_positions(out, description);
+  if (description->generator_walls) {
+    generate_generator_walls(out, description, size, &state);
+  } else {
+    generate_hexadecimal_walls(out, description, size, &state);
+  }
+
+  return true;
+}
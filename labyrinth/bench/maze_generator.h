@@ -0,0 +1,33 @@
+#ifndef MAZE_GENERATOR_H
+#define MAZE_GENERATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Maximal number of dimensions of a generated maze.
+#define GENERATOR_DIMENSIONS_MAX 64
+
+// Description of a maze generated for benchmarks. Start position is
+// 1 ... 1 and end position is the opposite corner.
+typedef struct {
+  size_t dimensions_number;
+  uint64_t dimensions[GENERATOR_DIMENSIONS_MAX];
+  // expected fraction of positions which are walls
+  double density;
+  uint64_t seed;
+  // whether walls are written as R generator instead of a hexadecimal
+  // number
+  bool generator_walls;
+  // whether a slab of walls across the first dimension separates start
+  // and end position; otherwise, a free path between them is carved
+  // (hexadecimal walls only)
+  bool no_way;
+} MazeDescription;
+
+// Writes maze input described by description to out. The same
+// description always gives the same maze. Returns false if description
+// is incorrect.
+bool generate_maze(FILE *out, MazeDescription *description);
+
+#endif  // MAZE_GENERATOR_H
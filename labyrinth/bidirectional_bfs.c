@@ -0,0 +1,110 @@
+#include "bidirectional_bfs.h"
+#include <stdbool.h>
+#include "bitset.h"
+#include "utils.h"
+#include "vector.h"
+
+// One direction of the search.
+typedef struct {
+  // positions reached from this side
+  Bitset *visited;
+  // hashes of positions of current and next depth
+  Vector *current_depth_positions;
+  Vector *next_depth_positions;
+  size_t depth;
+} Side;
+
+// Creates side which starts from given position.
+static Side side_create(size_t size, size_t position_hash) {
+  Side side = {bitset_create(size), vector_create(), vector_create(), 0};
+  bitset_set(side.visited, position_hash);
+  vector_push_back(side.current_depth_positions, position_hash);
+
+  return side;
+}
+
+static void side_free(Side *side) {
+  bitset_free(side->visited);
+  vector_free(side->current_depth_positions);
+  vector_free(side->next_depth_positions);
+}
+
+// Visits position from side if it's free. Returns true if it was already
+// reached from the other side.
+static bool visit_position(Bitset *walls, Side *side, Side *other,
+                           size_t position_hash) {
+  if (bitset_get(walls, position_hash)) {
+    return false;
+  }
+  if (bitset_get(other->visited, position_hash)) {
+    return true;
+  }
+
+  if (!bitset_get(side->visited, position_hash)) {
+    bitset_set(side->visited, position_hash);
+    vector_push_back(side->next_depth_positions, position_hash);
+  }
+
+  return false;
+}
+
+// Expands whole current level of side. Returns true if a position
+// reached from the other side was found. Such position always belongs
+// to current level of the other side.
+static bool expand_level(Maze *maze, Side *side, Side *other) {
+  Bitset *walls = maze_walls(maze);
+  vector_clear(side->next_depth_positions);
+
+  while (!vector_is_empty(side->current_depth_positions)) {
+    size_t position_hash = vector_pop_back(side->current_depth_positions);
+    size_t rest = position_hash, N = 1;
+
+    for (size_t i = 0; i < maze_dimensions_number(maze); i++) {
+      uint64_t n_i = maze_dimension(maze, i);
+      uint64_t z_i = rest % n_i;
+      rest /= n_i;
+
+      // decrement and increment i-th coordinate
+      if ((z_i > 0 && visit_position(walls, side, other, position_hash - N)) ||
+          (z_i + 1 < n_i &&
+           visit_position(walls, side, other, position_hash + N))) {
+        return true;
+      }
+
+      N *= n_i;
+    }
+  }
+
+  swap((void **)&side->current_depth_positions,
+       (void **)&side->next_depth_positions);
+  ++side->depth;
+
+  return false;
+}
+
+size_t bidirectional_find_shortest_path(Maze *maze) {
+  size_t answer = 0, size = maze_size(maze);
+  Side from_start = side_create(size, maze_start_position_hash(maze));
+  Side from_end = side_create(size, maze_end_position_hash(maze));
+
+  while (!vector_is_empty(from_start.current_depth_positions) &&
+         !vector_is_empty(from_end.current_depth_positions)) {
+    // expand the smaller level
+    Side *side = &from_start, *other = &from_end;
+    if (vector_size(from_end.current_depth_positions) <
+        vector_size(from_start.current_depth_positions)) {
+      side = &from_end;
+      other = &from_start;
+    }
+
+    if (expand_level(maze, side, other)) {
+      answer = side->depth + 1 + other->depth;
+      break;
+    }
+  }
+
+  side_free(&from_start);
+  side_free(&from_end);
+
+  return answer;
+}
@@ -0,0 +1,13 @@
+#ifndef BIDIRECTIONAL_BFS_H
+#define BIDIRECTIONAL_BFS_H
+
+#include <stddef.h>
+#include "maze.h"
+
+// Finds length of the shortest path from start to end position by
+// growing bfs levels from both of them, always expanding the smaller
+// one, until they meet. Returns 0 if the path doesn't exist. Doesn't
+// modify maze walls. Assumes that start and end positions are not equal.
+size_t bidirectional_find_shortest_path(Maze *maze);
+
+#endif  // BIDIRECTIONAL_BFS_H
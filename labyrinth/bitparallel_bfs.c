@@ -0,0 +1,237 @@
+#include "bitparallel_bfs.h"
+#include <stdbool.h>
+#include "bitset.h"
+#include "utils.h"
+#include "vector.h"
+
+#define BITS 64
+
+// State of a search. Every level is kept both as a bitmap and as a list
+// of indices of its non-zero words.
+typedef struct {
+  Grid *grid;
+  uint64_t *walls;
+  size_t words_number;
+  Bitset *current_depth_bitmap;
+  Bitset *next_depth_bitmap;
+  Vector *current_depth_words;
+  Vector *next_depth_words;
+} Search;
+
+// Ors words [begin, end) of dst with src shifted by shift bits towards
+// more significant bits, i.e. moves every position shift hashes forward.
+static void or_shifted_up(uint64_t *dst, uint64_t *src, size_t begin,
+                          size_t end, size_t shift) {
+  size_t q = shift / BITS, r = shift % BITS;
+  if (begin < q) {
+    begin = q;
+  }
+  if (begin == q && begin < end) {
+    // the lowest source word has no lower neighbour
+    dst[begin] |= src[0] << r;
+    ++begin;
+  }
+
+  if (r == 0) {
+    for (size_t w = begin; w < end; w++) {
+      dst[w] |= src[w - q];
+    }
+  } else {
+    for (size_t w = begin; w < end; w++) {
+      dst[w] |= (src[w - q] << r) | (src[w - q - 1] >> (BITS - r));
+    }
+  }
+}
+
+// Ors words [begin, end) of dst with src shifted by shift bits towards
+// less significant bits, i.e. moves every position shift hashes back.
+// Src has words_number words.
+static void or_shifted_down(uint64_t *dst, uint64_t *src, size_t begin,
+                            size_t end, size_t shift, size_t words_number) {
+  size_t q = shift / BITS, r = shift % BITS;
+  if (q >= words_number) {
+    return;
+  }
+  if (end > words_number - q) {
+    end = words_number - q;
+  }
+  if (begin < end && end == words_number - q) {
+    // the highest source word has no higher neighbour
+    dst[end - 1] |= src[end - 1 + q] >> r;
+    --end;
+  }
+
+  if (r == 0) {
+    for (size_t w = begin; w < end; w++) {
+      dst[w] |= src[w + q];
+    }
+  } else {
+    for (size_t w = begin; w < end; w++) {
+      dst[w] |= (src[w + q] >> r) | (src[w + q + 1] << (BITS - r));
+    }
+  }
+}
+
+// Computes candidates for the next level by shifting whole range of words
+// between the lowest and the highest non-zero word of current level.
+// Used when most of the words of that range are non-zero.
+static void spread_dense(Search *search, size_t first_word,
+                         size_t last_word) {
+  Grid *grid = search->grid;
+  uint64_t *current = bitset_data(search->current_depth_bitmap);
+  uint64_t *next = bitset_data(search->next_depth_bitmap);
+
+  // levels may only spread by the largest stride in one step
+  size_t max_shift_words =
+      grid->strides[grid->dimensions_number - 1] / BITS + 1;
+  size_t begin =
+      first_word > max_shift_words ? first_word - max_shift_words : 0;
+  size_t end = safe_sum(last_word, max_shift_words + 1);
+  if (end > search->words_number) {
+    end = search->words_number;
+  }
+
+  for (size_t i = 0; i < grid->dimensions_number; i++) {
+    or_shifted_up(next, current, begin, end, grid->strides[i]);
+    or_shifted_down(next, current, begin, end, grid->strides[i],
+                    search->words_number);
+  }
+
+  for (size_t w = begin; w < end; w++) {
+    if (next[w] != 0) {
+      vector_push_back(search->next_depth_words, w);
+    }
+  }
+}
+
+// Ors w-th word of the next level with value.
+static inline void add_to_word(Search *search, uint64_t *next, size_t w,
+                               uint64_t value) {
+  if (value != 0) {
+    if (next[w] == 0) {
+      vector_push_back(search->next_depth_words, w);
+    }
+    next[w] |= value;
+  }
+}
+
+// Computes candidates for the next level by shifting only non-zero words
+// of current level. Used when they are scattered.
+static void spread_sparse(Search *search) {
+  Grid *grid = search->grid;
+  uint64_t *current = bitset_data(search->current_depth_bitmap);
+  uint64_t *next = bitset_data(search->next_depth_bitmap);
+  uint64_t *words = vector_data(search->current_depth_words);
+  size_t words_number = vector_size(search->current_depth_words);
+
+  for (size_t j = 0; j < words_number; j++) {
+    size_t w = words[j];
+    uint64_t word = current[w];
+
+    // neighbours in the first dimension are mostly in the same word
+    add_to_word(search, next, w, (word << 1) | (word >> 1));
+    add_to_word(search, next, w + 1, word >> (BITS - 1));
+    add_to_word(search, next, w - 1, word << (BITS - 1));
+
+    for (size_t i = 1; i < grid->dimensions_number; i++) {
+      size_t q = grid->strides[i] / BITS, r = grid->strides[i] % BITS;
+      if (r == 0) {
+        add_to_word(search, next, w + q, word);
+        add_to_word(search, next, w - q, word);
+      } else {
+        add_to_word(search, next, w + q, word << r);
+        add_to_word(search, next, w + q + 1, word >> (BITS - r));
+        add_to_word(search, next, w - q, word >> r);
+        add_to_word(search, next, w - q - 1, word << (BITS - r));
+      }
+    }
+  }
+}
+
+// Removes walls and visited positions from the candidates for the next
+// level and marks the rest as visited. Returns false if the next level
+// is empty.
+static bool filter_next_level(Search *search) {
+  uint64_t *next = bitset_data(search->next_depth_bitmap);
+  uint64_t *words = vector_data(search->next_depth_words);
+  size_t kept = 0;
+
+  for (size_t j = 0; j < vector_size(search->next_depth_words); j++) {
+    size_t w = words[j];
+    next[w] &= ~search->walls[w];
+    search->walls[w] |= next[w];
+    if (next[w] != 0) {
+      words[kept++] = w;
+    }
+  }
+
+  vector_resize(search->next_depth_words, kept);
+
+  return kept > 0;
+}
+
+// Computes the next level and makes it the current one. Returns false if
+// it's empty.
+static bool bitparallel_step(Search *search) {
+  size_t words = vector_size(search->current_depth_words);
+  size_t first_word = SIZE_MAX, last_word = 0;
+  for (size_t j = 0; j < words; j++) {
+    size_t w = vector_get(search->current_depth_words, j);
+    first_word = w < first_word ? w : first_word;
+    last_word = w > last_word ? w : last_word;
+  }
+
+  vector_clear(search->next_depth_words);
+  size_t sparse_cost = safe_product(words, 4 * search->grid->dimensions_number);
+  if (sparse_cost > last_word - first_word) {
+    spread_dense(search, first_word, last_word);
+  } else {
+    spread_sparse(search);
+  }
+  bool next_level_empty = !filter_next_level(search);
+
+  // clear current level, so it can be reused for the level after next one
+  uint64_t *current = bitset_data(search->current_depth_bitmap);
+  for (size_t j = 0; j < words; j++) {
+    current[vector_get(search->current_depth_words, j)] = 0;
+  }
+
+  swap((void **)&search->current_depth_bitmap,
+       (void **)&search->next_depth_bitmap);
+  swap((void **)&search->current_depth_words,
+       (void **)&search->next_depth_words);
+
+  return !next_level_empty;
+}
+
+size_t bitparallel_find_shortest_path(Grid *grid) {
+  Search search = {grid,
+                   bitset_data(grid->walls),
+                   bitset_words_number(grid->walls),
+                   bitset_create(grid->size),
+                   bitset_create(grid->size),
+                   vector_create(),
+                   vector_create()};
+
+  // initialize bfs using start position
+  bitset_set(search.current_depth_bitmap, grid->start_position_hash);
+  bitset_set(grid->walls, grid->start_position_hash);
+  vector_push_back(search.current_depth_words,
+                   grid->start_position_hash / BITS);
+
+  size_t answer = 0, depth = 0;
+  while (bitparallel_step(&search)) {
+    ++depth;
+    if (bitset_get(search.current_depth_bitmap, grid->end_position_hash)) {
+      answer = depth;
+      break;
+    }
+  }
+
+  bitset_free(search.current_depth_bitmap);
+  bitset_free(search.next_depth_bitmap);
+  vector_free(search.current_depth_words);
+  vector_free(search.next_depth_words);
+
+  return answer;
+}
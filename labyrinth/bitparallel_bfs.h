@@ -0,0 +1,14 @@
+#ifndef BITPARALLEL_BFS_H
+#define BITPARALLEL_BFS_H
+
+#include <stddef.h>
+#include "grid.h"
+
+// Finds length of the shortest path from start to end position of grid
+// using bfs, which keeps each level as a bitmap and computes the next one
+// with word shifts, ORs and AND-NOTs, 64 positions at a time. Returns 0
+// if the path doesn't exist. Marks visited positions as grid walls.
+// Assumes that start and end positions are not equal.
+size_t bitparallel_find_shortest_path(Grid *grid);
+
+#endif  // BITPARALLEL_BFS_H
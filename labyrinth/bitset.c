@@ -1,16 +1,256 @@
+#define _DEFAULT_SOURCE
+
 #include "bitset.h"
-#include <ctype.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include "parallel.h"
 #include "utils.h"
 
 // Bits stored in one element of bitset
 #define BITS 64
 
+// Larger bitsets are mapped directly, so their pages are committed only
+// when they're written for the first time.
+#define MAPPED_BYTES_MIN (1 << 21)
+
+// Compressed bitsets are split into chunks of this many bits.
+#define CHUNK_BITS (1 << 16)
+
+// Words of one chunk.
+#define CHUNK_WORDS (CHUNK_BITS / BITS)
+
+// Bitsets are compressed only if that divides their memory at least by
+// this number.
+#define COMPRESSION_RATIO_MIN 2
+
+// Bitsets with fewer chunks are compressed by a single thread.
+#define PARALLEL_CHUNKS_MIN 64
+
+// Representations of a chunk of a compressed bitset.
+typedef enum {
+  // sorted offsets of set bits
+  CONTAINER_ARRAY,
+  // offsets of the first and the last bit of every run of set bits,
+  // sorted
+  CONTAINER_RUNS,
+  // words of the chunk, as in an uncompressed bitset
+  CONTAINER_BITMAP,
+} ContainerType;
+
+// Chunk of a compressed bitset, stored in the smallest of representations.
+typedef struct {
+  union {
+    uint16_t *values;
+    uint16_t *runs;
+    uint64_t *words;
+  };
+  // number of values of an array or runs of a run container
+  uint32_t number;
+  // number of set bits
+  uint32_t cardinality;
+  ContainerType type;
+} Container;
+
 struct Bitset {
+  // words of bitset or NULL if it's compressed
   uint64_t *data;
   size_t size;
+  // bit i is stored as bit (i & mask), so that bits of a periodic bitset
+  // repeat after mask + 1 bits; SIZE_MAX for other bitsets
+  size_t mask;
+  // whether data is an anonymous mapping instead of a heap allocation
+  bool mapped;
+  // whether data is a mapping of a file, which isn't reused
+  bool from_file;
+  // number of words of data, which may be more than the bitset uses when
+  // it's reused
+  size_t capacity;
+  // chunks of a compressed bitset or NULL
+  Container *containers;
 };
 
+// Returns the smallest i < n such that values[stride * i] >= x or n if
+// there's none. Values must be sorted.
+static size_t lower_bound(const uint16_t *values, size_t n, size_t stride,
+                          uint32_t x) {
+  size_t low = 0, high = n;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (values[stride * middle] < x) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  return low;
+}
+
+// Checks if offset-th bit of chunk is set.
+static bool container_get(Container *container, uint32_t offset) {
+  if (container->type == CONTAINER_BITMAP) {
+    return (container->words[offset / BITS] >> (offset % BITS)) & 1;
+  }
+
+  if (container->type == CONTAINER_ARRAY) {
+    size_t i = lower_bound(container->values, container->number, 1, offset);
+    return i < container->number && container->values[i] == offset;
+  }
+
+  // the first run that doesn't end before offset
+  size_t i = lower_bound(container->runs + 1, container->number, 2, offset);
+  return i < container->number && container->runs[2 * i] <= offset;
+}
+
+// Returns w-th word of chunk.
+static uint64_t container_word(Container *container, size_t w) {
+  if (container->type == CONTAINER_BITMAP) {
+    return container->words[w];
+  }
+
+  uint32_t first = (uint32_t)(w * BITS), last = first + BITS - 1;
+  uint64_t word = 0;
+  if (container->type == CONTAINER_ARRAY) {
+    for (size_t i = lower_bound(container->values, container->number, 1,
+                                first);
+         i < container->number && container->values[i] <= last; i++) {
+      word |= 1ULL << (container->values[i] - first);
+    }
+
+    return word;
+  }
+
+  for (size_t i = lower_bound(container->runs + 1, container->number, 2,
+                              first);
+       i < container->number && container->runs[2 * i] <= last; i++) {
+    uint32_t begin = container->runs[2 * i] > first ? container->runs[2 * i]
+                                                    : first;
+    uint32_t end = container->runs[2 * i + 1] < last
+                       ? container->runs[2 * i + 1]
+                       : last;
+    uint32_t length = end - begin + 1;
+    uint64_t run = length < BITS ? (1ULL << length) - 1 : UINT64_MAX;
+    word |= run << (begin - first);
+  }
+
+  return word;
+}
+
+// Counts set bits and runs of set bits of n words of a chunk.
+static void measure_chunk(const uint64_t *words, size_t n,
+                          uint32_t *cardinality, uint32_t *runs) {
+  *cardinality = 0;
+  *runs = 0;
+  uint64_t previous = 0;
+  for (size_t w = 0; w < n; w++) {
+    if (words[w] == 0) {
+      // sparse chunks are mostly empty words
+      previous = 0;
+      continue;
+    }
+
+    // a run starts at a set bit that doesn't follow a set bit
+    uint64_t starts = words[w] & ~((words[w] << 1) | previous);
+    *cardinality += (uint32_t)__builtin_popcountll(words[w]);
+    *runs += (uint32_t)__builtin_popcountll(starts);
+    previous = words[w] >> (BITS - 1);
+  }
+}
+
+// Returns the smallest representation of a chunk with given numbers of
+// set bits and runs. Bitmaps win ties, as they're read the fastest.
+static ContainerType container_type(uint32_t cardinality, uint32_t runs) {
+  size_t array_bytes = cardinality * sizeof(uint16_t);
+  size_t runs_bytes = 2 * runs * sizeof(uint16_t);
+  size_t bitmap_bytes = CHUNK_WORDS * sizeof(uint64_t);
+
+  if (runs_bytes < array_bytes && runs_bytes < bitmap_bytes) {
+    return CONTAINER_RUNS;
+  }
+
+  return array_bytes < bitmap_bytes ? CONTAINER_ARRAY : CONTAINER_BITMAP;
+}
+
+// Returns bytes taken by a chunk with given numbers of set bits and runs.
+static size_t container_bytes(uint32_t cardinality, uint32_t runs) {
+  switch (container_type(cardinality, runs)) {
+    case CONTAINER_ARRAY:
+      return sizeof(Container) + cardinality * sizeof(uint16_t);
+    case CONTAINER_RUNS:
+      return sizeof(Container) + 2 * runs * sizeof(uint16_t);
+    default:
+      return sizeof(Container) + CHUNK_WORDS * sizeof(uint64_t);
+  }
+}
+
+// Fills container with n words of a chunk.
+static void container_init(Container *container, const uint64_t *words,
+                           size_t n) {
+  uint32_t runs;
+  measure_chunk(words, n, &container->cardinality, &runs);
+  container->type = container_type(container->cardinality, runs);
+
+  if (container->type == CONTAINER_BITMAP) {
+    container->words =
+        (uint64_t *)safe_calloc(CHUNK_WORDS, sizeof(uint64_t));
+    memcpy(container->words, words, n * sizeof(uint64_t));
+    container->number = 0;
+    return;
+  }
+
+  container->number =
+      container->type == CONTAINER_ARRAY ? container->cardinality : runs;
+  size_t values_number = container->type == CONTAINER_ARRAY
+                             ? container->cardinality
+                             : 2 * (size_t)runs;
+  container->values =
+      values_number > 0
+          ? (uint16_t *)safe_malloc(values_number * sizeof(uint16_t))
+          : NULL;
+
+  size_t i = 0, j = 0;
+  uint64_t previous = 0;
+  for (size_t w = 0; w < n; w++) {
+    if (container->type == CONTAINER_ARRAY) {
+      for (uint64_t word = words[w]; word != 0; word &= word - 1) {
+        container->values[i++] =
+            (uint16_t)(w * BITS + (size_t)__builtin_ctzll(word));
+      }
+      continue;
+    }
+
+    // a run ends at a set bit that isn't followed by a set bit
+    uint64_t next = w + 1 < n ? words[w + 1] << (BITS - 1) : 0;
+    uint64_t starts = words[w] & ~((words[w] << 1) | previous);
+    uint64_t ends = words[w] & ~((words[w] >> 1) | next);
+    for (; starts != 0; starts &= starts - 1) {
+      container->runs[2 * i++] =
+          (uint16_t)(w * BITS + (size_t)__builtin_ctzll(starts));
+    }
+    for (; ends != 0; ends &= ends - 1) {
+      container->runs[2 * j++ + 1] =
+          (uint16_t)(w * BITS + (size_t)__builtin_ctzll(ends));
+    }
+    previous = words[w] >> (BITS - 1);
+  }
+}
+
+// Returns number of chunks of a compressed bitset.
+static size_t chunks_number(Bitset *bitset) {
+  return (bitset_words_number(bitset) + CHUNK_WORDS - 1) / CHUNK_WORDS;
+}
+
+// Returns w-th stored word of bitset.
+static inline uint64_t stored_word(Bitset *bitset, size_t w) {
+  if (bitset->containers == NULL) {
+    return bitset->data[w];
+  }
+
+  return container_word(&bitset->containers[w / CHUNK_WORDS],
+                        w % CHUNK_WORDS);
+}
+
 // Checks if a generator is correct.
 static bool is_correct_generator(Vector *gen) {
   if (gen == NULL || vector_size(gen) != 5 || vector_get(gen, 2) == 0) {
@@ -25,102 +265,454 @@ static bool is_correct_generator(Vector *gen) {
   return true;
 }
 
-// Returns hexadecimal number size if it's correct or 0 otherwise.
-static size_t is_correct_hexadecimal(char *hex) {
-  if (hex[0] != '0' || hex[1] != 'x' || hex[2] == '\0') {
-    return 0;
+// Returns n <= 64 bits of bitset starting from i-th.
+static uint64_t read_bits(Bitset *bitset, size_t i, size_t n) {
+  size_t w = i / BITS, offset = i % BITS;
+  uint64_t value = stored_word(bitset, w) >> offset;
+  if (offset != 0 && offset + n > BITS) {
+    value |= stored_word(bitset, w + 1) << (BITS - offset);
+  }
+
+  return n < BITS ? value & ((1ULL << n) - 1) : value;
+}
+
+// Overwrites n <= 64 bits of bitset starting from i-th with value.
+static void write_bits(Bitset *bitset, size_t i, uint64_t value, size_t n) {
+  size_t w = i / BITS, offset = i % BITS;
+  uint64_t mask = n < BITS ? (1ULL << n) - 1 : UINT64_MAX;
+  value &= mask;
+
+  bitset->data[w] = (bitset->data[w] & ~(mask << offset)) | (value << offset);
+  if (offset != 0 && offset + n > BITS) {
+    bitset->data[w + 1] = (bitset->data[w + 1] & ~(mask >> (BITS - offset))) |
+                          (value >> (BITS - offset));
   }
+}
+
+// Hexadecimal numbers with fewer digits are decoded by a single thread.
+#define PARALLEL_DIGITS_MIN (1 << 20)
 
-  size_t hex_size = 2;
-  while (hex[hex_size] != '\0') {
-    if (!isxdigit(hex[hex_size++])) {
-      return 0;
+// Value of characters which aren't hexadecimal digits.
+#define NOT_DIGIT 0xFF
+
+// Fills table of digit values of characters.
+static void init_digit_values(uint8_t *values) {
+  memset(values, NOT_DIGIT, 256);
+  for (int c = '0'; c <= '9'; c++) {
+    values[c] = (uint8_t)(c - '0');
+  }
+  for (int c = 'a'; c <= 'f'; c++) {
+    values[c] = (uint8_t)(c - 'a' + 10);
+    values[c - 'a' + 'A'] = (uint8_t)(c - 'a' + 10);
+  }
+}
+
+struct HexStream {
+  Bitset *bitset;
+  uint8_t values[256];
+  // digits after leading zeros, the i-th of them is kept as i-th nibble
+  size_t digits_number;
+  size_t max_digits_number;
+  // nibbles of the word that isn't filled yet
+  uint64_t word;
+  bool any_digit;
+  bool too_big;
+};
+
+// Reverses order of nibbles of word.
+static uint64_t reverse_nibbles(uint64_t word) {
+  word = __builtin_bswap64(word);
+  return ((word & 0x0F0F0F0F0F0F0F0FULL) << 4) |
+         ((word >> 4) & 0x0F0F0F0F0F0F0F0FULL);
+}
+
+HexStream *bitset_hex_stream_create(size_t size, Bitset *reused) {
+  HexStream *stream = (HexStream *)safe_calloc(1, sizeof(HexStream));
+  stream->bitset = bitset_recreate(reused, size);
+  init_digit_values(stream->values);
+  stream->max_digits_number = size / 4 + (size % 4 != 0);
+
+  return stream;
+}
+
+// Digits of a hexadecimal number shared by threads that decode them.
+typedef struct {
+  HexStream *stream;
+  const char *chars;
+  size_t n;
+  size_t threads;
+  // position of the first character that isn't a digit found by every
+  // thread, n if there's none
+  size_t *ends;
+} StreamPart;
+
+// Finds the first character of id-th part of chars that isn't a digit.
+static void find_digits_end(void *part_ptr, size_t id) {
+  StreamPart *part = (StreamPart *)part_ptr;
+  size_t begin = part->n * id / part->threads;
+  size_t end = part->n * (id + 1) / part->threads;
+
+  size_t i = begin;
+  while (i < end && part->stream->values[(unsigned char)part->chars[i]] <=
+                        0xF) {
+    ++i;
+  }
+  part->ends[id] = i < end ? i : part->n;
+}
+
+// Decodes id-th part of whole words made of chars, 16 digits each. The
+// first digit of chars is the first nibble of a word.
+static void decode_stream_words(void *part_ptr, size_t id) {
+  StreamPart *part = (StreamPart *)part_ptr;
+  HexStream *stream = part->stream;
+  uint64_t *data = stream->bitset->data + stream->digits_number / 16;
+  size_t words = part->n / 16;
+  size_t begin = words * id / part->threads;
+  size_t end = words * (id + 1) / part->threads;
+
+  for (size_t w = begin; w < end; w++) {
+    const char *digits = &part->chars[16 * w];
+    uint64_t word = 0;
+    for (size_t nibble = 0; nibble < 16; nibble++) {
+      word |= (uint64_t)stream->values[(unsigned char)digits[nibble]]
+              << (4 * nibble);
+    }
+    data[w] = word;
+  }
+}
+
+// Decodes n digits, which all are hexadecimal digits and fit in bitset.
+static void decode_digits(HexStream *stream, const char *chars, size_t n) {
+  uint64_t *data = stream->bitset->data;
+  size_t i = 0;
+
+  // fill the started word first, so that the rest are whole words
+  while (i < n && (stream->digits_number % 16 != 0 || n - i < 16)) {
+    uint8_t value = stream->values[(unsigned char)chars[i++]];
+    size_t nibble = stream->digits_number++ % 16;
+    stream->word |= (uint64_t)value << (4 * nibble);
+    if (nibble == 15) {
+      data[stream->digits_number / 16 - 1] = stream->word;
+      stream->word = 0;
     }
   }
+  if (i == n) {
+    return;
+  }
+
+  size_t words_digits = (n - i) / 16 * 16;
+  StreamPart part = {stream, &chars[i], words_digits, 1, NULL};
+  if (words_digits >= PARALLEL_DIGITS_MIN) {
+    part.threads = parallel_threads();
+  }
+  parallel_run(part.threads, decode_stream_words, &part);
+  stream->digits_number += words_digits;
 
-  return hex_size;
+  decode_digits(stream, &chars[i + words_digits], n - i - words_digits);
 }
 
-// Creates bitset from a hexadecimal number represented as string.
-// If it's incorrect or there exists bit >= bitset_size, returns NULL.
-static Bitset *bitset_create_from_hexadecimal(char *hex, size_t bitset_size) {
-  size_t hex_size = is_correct_hexadecimal(hex);
-  if (hex_size == 0) {
-    // incorrect hexadecimal number
-    return NULL;
+size_t bitset_hex_stream_feed(HexStream *stream, const char *chars,
+                              size_t n) {
+  size_t i = 0;
+
+  // skip leading zeros, which may be arbitrarily many
+  while (stream->digits_number == 0 && i < n && chars[i] == '0') {
+    stream->any_digit = true;
+    ++i;
+  }
+  if (i == n) {
+    return n;
   }
 
-  Bitset *bitset = bitset_create(bitset_size);
-  size_t bit_number = 0;
-  for (size_t i = hex_size - 1; i >= 2; i--) {
-    int digit = (int)strtoul(&hex[i], NULL, 16);
-    hex[i] = '\0';
+  // find where digits end, in parallel for long parts
+  StreamPart part = {stream, &chars[i], n - i, 1, NULL};
+  if (part.n >= PARALLEL_DIGITS_MIN) {
+    part.threads = parallel_threads();
+  }
+  part.ends = (size_t *)safe_calloc(part.threads, sizeof(size_t));
+  parallel_run(part.threads, find_digits_end, &part);
+  size_t digits = part.n;
+  for (size_t id = 0; id < part.threads && digits == part.n; id++) {
+    digits = part.ends[id];
+  }
+  free(part.ends);
 
-    for (uint32_t j = 0; j <= 3; j++) {
-      if ((digit & (1 << j)) && !bitset_set(bitset, bit_number)) {
-        // tried to set bit over bitset size
-        bitset_free(bitset);
-        return NULL;
-      }
+  stream->any_digit = stream->any_digit || digits > 0;
+  size_t room = stream->max_digits_number - stream->digits_number;
+  if (digits > room) {
+    // number sets a bit over bitset size, but the digits are consumed
+    stream->too_big = true;
+  }
+  decode_digits(stream, &chars[i], digits < room ? digits : room);
 
-      ++bit_number;
+  return i + digits;
+}
+
+Bitset *bitset_hex_stream_finish(HexStream *stream) {
+  Bitset *bitset = stream->bitset;
+  uint64_t *data = bitset->data;
+  size_t digits_number = stream->digits_number;
+  size_t words = digits_number / 16 + (digits_number % 16 != 0);
+  if (digits_number % 16 != 0) {
+    data[words - 1] = stream->word;
+  }
+
+  // digits arrived from the most significant one, so reverse their order
+  for (size_t i = 0; i < words / 2; i++) {
+    uint64_t word = data[i];
+    data[i] = reverse_nibbles(data[words - 1 - i]);
+    data[words - 1 - i] = reverse_nibbles(word);
+  }
+  if (words % 2 == 1) {
+    data[words / 2] = reverse_nibbles(data[words / 2]);
+  }
+
+  // the least significant digit is now at nibble 16 * words - digits_number
+  size_t shift = 4 * (16 * words - digits_number);
+  if (shift > 0) {
+    for (size_t i = 0; i < words; i++) {
+      data[i] >>= shift;
+      if (i + 1 < words) {
+        data[i] |= data[i + 1] << (BITS - shift);
+      }
     }
   }
 
+  bool correct = stream->any_digit && !stream->too_big &&
+                 (data[bitset->size / BITS] >> (bitset->size % BITS)) == 0;
+  free(stream);
+
+  if (!correct) {
+    bitset_free(bitset);
+    return NULL;
+  }
+
   return bitset;
 }
 
+// Generator walls repeat after this number of bits.
+#define GENERATOR_PERIOD (1ULL << 32)
+
+// Generator walls of larger mazes are stored for one period only.
+#define PERIODIC_SIZE_MIN (1ULL << 36)
+
+// Generators with fewer steps are run by a single thread.
+#define PARALLEL_STEPS_MIN (1 << 16)
+
+// Affine map x -> (a * x + b) mod m.
+typedef struct {
+  uint64_t a;
+  uint64_t b;
+} AffineMap;
+
+// Returns map g(f(x)). Assumes that coefficients are smaller than m.
+static AffineMap compose(AffineMap f, AffineMap g, uint64_t m) {
+  return (AffineMap){g.a * f.a % m, (g.a * f.b + g.b) % m};
+}
+
+// Returns map f applied n times.
+static AffineMap power(AffineMap f, uint64_t n, uint64_t m) {
+  AffineMap result = {1 % m, 0};
+  while (n > 0) {
+    if (n & 1) {
+      result = compose(result, f, m);
+    }
+    f = compose(f, f, m);
+    n >>= 1;
+  }
+
+  return result;
+}
+
+// Generator shared by threads that set walls.
+typedef struct {
+  Bitset *bitset;
+  AffineMap step;
+  uint64_t m;
+  uint64_t r;
+  uint64_t s;
+  size_t threads;
+} Generator;
+
+// Runs id-th part of generator steps. Every thread jumps directly to the
+// first of its steps and sets bits of the first period only.
+static void generate_walls(void *generator_ptr, size_t id) {
+  Generator *gen = (Generator *)generator_ptr;
+  uint64_t begin = gen->r * id / gen->threads;
+  uint64_t end = gen->r * (id + 1) / gen->threads;
+
+  uint64_t s = gen->s;
+  if (begin > 0) {
+    AffineMap jump = power(gen->step, begin, gen->m);
+    s = (jump.a * s + jump.b) % gen->m;
+  }
+
+  size_t size = gen->bitset->size;
+  for (uint64_t i = begin; i < end; i++) {
+    s = (gen->step.a * s + gen->step.b) % gen->m;
+    size_t w_i = s < size ? s : s % size;
+
+    if (gen->threads > 1) {
+      bitset_test_and_set(gen->bitset, w_i);
+    } else {
+      bitset_set(gen->bitset, w_i);
+    }
+  }
+}
+
+// Copies id-th part of words after the first period from the
+// corresponding words of the first period.
+static void repeat_period(void *generator_ptr, size_t id) {
+  Generator *gen = (Generator *)generator_ptr;
+  uint64_t *data = gen->bitset->data;
+  size_t period_words = GENERATOR_PERIOD / BITS;
+  size_t words = bitset_words_number(gen->bitset) - period_words;
+
+  size_t w = period_words + words * id / gen->threads;
+  size_t end = period_words + words * (id + 1) / gen->threads;
+  while (w < end) {
+    size_t offset = w % period_words;
+    size_t length = period_words - offset < end - w ? period_words - offset
+                                                     : end - w;
+    memcpy(&data[w], &data[offset], length * sizeof(uint64_t));
+    w += length;
+  }
+}
+
 // Creates bitset from a generator. If it's incorrect, returns NULL.
-static Bitset *bitset_create_from_generator(Vector *gen, size_t bitset_size) {
+// Walls set by the generator repeat with period 2^32, so only the first
+// period is generated and then copied word by word. For very large sizes
+// the bitset stays periodic instead.
+static Bitset *bitset_create_from_generator(Vector *gen, size_t bitset_size,
+                                            Bitset *reused) {
   if (!is_correct_generator(gen)) {
+    bitset_free(reused);
     return NULL;
   }
 
-  Bitset *bitset = bitset_create(bitset_size);
-  uint64_t a = vector_get(gen, 0), b = vector_get(gen, 1),
-           m = vector_get(gen, 2), r = vector_get(gen, 3),
-           s = vector_get(gen, 4);
+  bool periodic = bitset_size >= PERIODIC_SIZE_MIN;
+  uint64_t m = vector_get(gen, 2);
+  Generator generator = {
+      bitset_recreate(reused, periodic ? GENERATOR_PERIOD : bitset_size),
+      {vector_get(gen, 0) % m, vector_get(gen, 1) % m},
+      m,
+      vector_get(gen, 3),
+      vector_get(gen, 4),
+      vector_get(gen, 3) < PARALLEL_STEPS_MIN ? 1 : parallel_threads(),
+  };
+  parallel_run(generator.threads, generate_walls, &generator);
 
-  for (uint32_t i = 0; i < r; i++) {
-    s = (a * s + b) % m;
-    size_t w_i = s % bitset_size;
+  if (periodic) {
+    generator.bitset->size = bitset_size;
+    generator.bitset->mask = GENERATOR_PERIOD - 1;
+  } else if (bitset_size > GENERATOR_PERIOD) {
+    generator.threads = parallel_threads();
+    parallel_run(generator.threads, repeat_period, &generator);
 
-    if (!bitset_get(bitset, w_i)) {
-      // set all bits that satisfy  bit mod 2^32 = w_i
-      while (w_i < bitset_size) {
-        bitset_set(bitset, w_i);
-        w_i = safe_sum(w_i, 1ULL << 32);
-      }
+    // clear copied bits past the end of bitset
+    generator.bitset->data[bitset_size / BITS] &=
+        (1ULL << (bitset_size % BITS)) - 1;
+  }
+
+  return generator.bitset;
+}
+
+Bitset *bitset_create(size_t size) {
+  Bitset *bitset = (Bitset *)safe_malloc(sizeof(Bitset));
+  size_t bytes = (1 + size / BITS) * sizeof(uint64_t);
+  bitset->from_file = false;
+  bitset->capacity = 1 + size / BITS;
+  bitset->mapped = bytes >= MAPPED_BYTES_MIN;
+  if (bitset->mapped) {
+    // anonymous mapping is zeroed and reserves no memory up front
+    void *data = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (data == MAP_FAILED) {
+      error(0);
     }
+    bitset->data = (uint64_t *)data;
+  } else {
+    bitset->data = (uint64_t *)safe_calloc(1 + size / BITS, sizeof(uint64_t));
   }
+  bitset->size = size;
+  bitset->mask = SIZE_MAX;
+  bitset->containers = NULL;
 
   return bitset;
 }
 
-Bitset *bitset_create(size_t size) {
+Bitset *bitset_recreate(Bitset *bitset, size_t size) {
+  size_t words_number = 1 + size / BITS;
+  if (bitset == NULL || bitset->containers != NULL || bitset->from_file ||
+      bitset->capacity < words_number) {
+    bitset_free(bitset);
+    return bitset_create(size);
+  }
+
+  if (bitset->mapped) {
+    // released pages are read as zeros and committed again when written
+    madvise(bitset->data, bitset->capacity * sizeof(uint64_t),
+            MADV_DONTNEED);
+  } else {
+    memset(bitset->data, 0, words_number * sizeof(uint64_t));
+  }
+  bitset->size = size;
+  bitset->mask = SIZE_MAX;
+
+  return bitset;
+}
+
+Bitset *bitset_map_file(int fd, size_t offset, size_t size, bool periodic) {
+  size_t stored_size = periodic ? GENERATOR_PERIOD : size;
+  size_t bytes = (1 + stored_size / BITS) * sizeof(uint64_t);
+  void *data = mmap(NULL, bytes, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_NORESERVE, fd, (off_t)offset);
+  if (data == MAP_FAILED) {
+    return NULL;
+  }
+
   Bitset *bitset = (Bitset *)safe_malloc(sizeof(Bitset));
-  bitset->data = (uint64_t *)safe_calloc(1 + size / 64, sizeof(uint64_t));
+  bitset->data = (uint64_t *)data;
   bitset->size = size;
+  bitset->mask = periodic ? GENERATOR_PERIOD - 1 : SIZE_MAX;
+  bitset->mapped = true;
+  bitset->from_file = true;
+  bitset->capacity = 1 + stored_size / BITS;
+  bitset->containers = NULL;
+
+  if (bitset->data[stored_size / BITS] >> (stored_size % BITS) != 0) {
+    bitset_free(bitset);
+    return NULL;
+  }
 
   return bitset;
 }
 
-Bitset *bitset_create_from_string(char *str, size_t size) {
-  Bitset *walls = NULL;
-  if (str[0] == '0') {
-    walls = bitset_create_from_hexadecimal(str, size);
-  } else if (str[0] == 'R') {
-    Vector *gen = vector_create_from_string(&str[1]);
-    walls = bitset_create_from_generator(gen, size);
-    vector_free(gen);
+Bitset *bitset_create_from_string(char *str, size_t size, Bitset *reused) {
+  if (str[0] != 'R') {
+    bitset_free(reused);
+    return NULL;
   }
 
+  Vector *gen = vector_create_from_string(&str[1]);
+  Bitset *walls = bitset_create_from_generator(gen, size, reused);
+  vector_free(gen);
+
   return walls;
 }
 
 void bitset_free(Bitset *bitset) {
   if (bitset != NULL) {
-    free(bitset->data);
+    if (bitset->containers != NULL) {
+      for (size_t c = 0; c < chunks_number(bitset); c++) {
+        free(bitset->containers[c].values);
+      }
+      free(bitset->containers);
+    } else if (bitset->mapped) {
+      munmap(bitset->data, bitset->capacity * sizeof(uint64_t));
+    } else {
+      free(bitset->data);
+    }
     free(bitset);
   }
 }
@@ -131,15 +723,291 @@ bool bitset_set(Bitset *bitset, size_t i) {
   }
 
   uint64_t n = i / BITS;
-  uint64_t m = i - n;
+  uint64_t m = i % BITS;
   bitset->data[n] |= (1ULL << m);
 
   return true;
 }
 
+void bitset_unset(Bitset *bitset, size_t i) {
+  bitset->data[i / BITS] &= ~(1ULL << (i % BITS));
+}
+
 bool bitset_get(Bitset *bitset, size_t i) {
+  i &= bitset->mask;
+  if (bitset->containers != NULL) {
+    return container_get(&bitset->containers[i / CHUNK_BITS],
+                         (uint32_t)(i % CHUNK_BITS));
+  }
+
   uint64_t n = i / BITS;
-  uint64_t m = i - n;
+  uint64_t m = i % BITS;
 
   return (bitset->data[n] & (1ULL << m)) > 0;
 }
+
+size_t bitset_size(Bitset *bitset) {
+  return bitset->size;
+}
+
+uint64_t *bitset_data(Bitset *bitset) {
+  return bitset->data;
+}
+
+size_t bitset_words_number(Bitset *bitset) {
+  return 1 + (bitset_is_periodic(bitset) ? bitset->mask + 1 : bitset->size) /
+                 BITS;
+}
+
+bool bitset_is_periodic(Bitset *bitset) {
+  return bitset->mask != SIZE_MAX;
+}
+
+// Compression shared by threads that convert chunks.
+typedef struct {
+  Bitset *bitset;
+  Container *containers;
+  size_t chunks;
+  size_t threads;
+  // bytes of compressed chunks counted by every thread
+  size_t *bytes;
+} Compression;
+
+// Returns number of words of c-th chunk of bitset.
+static size_t chunk_words(Bitset *bitset, size_t c) {
+  size_t words = bitset_words_number(bitset) - c * CHUNK_WORDS;
+  return words < CHUNK_WORDS ? words : CHUNK_WORDS;
+}
+
+// Counts bytes that id-th part of chunks would take when compressed.
+static void measure_chunks(void *compression_ptr, size_t id) {
+  Compression *compression = (Compression *)compression_ptr;
+  Bitset *bitset = compression->bitset;
+  size_t begin = compression->chunks * id / compression->threads;
+  size_t end = compression->chunks * (id + 1) / compression->threads;
+
+  size_t bytes = 0;
+  for (size_t c = begin; c < end; c++) {
+    uint32_t cardinality, runs;
+    measure_chunk(&bitset->data[c * CHUNK_WORDS], chunk_words(bitset, c),
+                  &cardinality, &runs);
+    bytes += container_bytes(cardinality, runs);
+  }
+  compression->bytes[id] = bytes;
+}
+
+// Converts id-th part of chunks. Pages of a mapped bitset are released
+// as soon as their chunk is converted, so that memory doesn't grow.
+static void compress_chunks(void *compression_ptr, size_t id) {
+  Compression *compression = (Compression *)compression_ptr;
+  Bitset *bitset = compression->bitset;
+  size_t begin = compression->chunks * id / compression->threads;
+  size_t end = compression->chunks * (id + 1) / compression->threads;
+
+  for (size_t c = begin; c < end; c++) {
+    uint64_t *words = &bitset->data[c * CHUNK_WORDS];
+    container_init(&compression->containers[c], words,
+                   chunk_words(bitset, c));
+    if (bitset->mapped) {
+      madvise(words, chunk_words(bitset, c) * sizeof(uint64_t),
+              MADV_DONTNEED);
+    }
+  }
+}
+
+bool bitset_compress(Bitset *bitset) {
+  if (bitset->containers != NULL) {
+    return true;
+  }
+
+  size_t words_number = bitset_words_number(bitset);
+  Compression compression = {bitset, NULL, 0, 1, NULL};
+  compression.chunks = chunks_number(bitset);
+  if (compression.chunks >= PARALLEL_CHUNKS_MIN) {
+    compression.threads = parallel_threads();
+  }
+  compression.bytes =
+      (size_t *)safe_calloc(compression.threads, sizeof(size_t));
+  parallel_run(compression.threads, measure_chunks, &compression);
+
+  size_t bytes = 0;
+  for (size_t id = 0; id < compression.threads; id++) {
+    bytes += compression.bytes[id];
+  }
+  free(compression.bytes);
+  if (bytes > words_number * sizeof(uint64_t) / COMPRESSION_RATIO_MIN) {
+    return false;
+  }
+
+  compression.containers =
+      (Container *)safe_calloc(compression.chunks, sizeof(Container));
+  parallel_run(compression.threads, compress_chunks, &compression);
+
+  if (bitset->mapped) {
+    munmap(bitset->data, bitset->capacity * sizeof(uint64_t));
+  } else {
+    free(bitset->data);
+  }
+  bitset->data = NULL;
+  bitset->mapped = false;
+  bitset->from_file = false;
+  bitset->capacity = 0;
+  bitset->containers = compression.containers;
+
+  return true;
+}
+
+bool bitset_is_compressed(Bitset *bitset) {
+  return bitset->containers != NULL;
+}
+
+uint64_t bitset_word(Bitset *bitset, size_t w) {
+  return stored_word(bitset, w);
+}
+
+void bitset_clear(Bitset *bitset) {
+  memset(bitset->data, 0, bitset_words_number(bitset) * sizeof(uint64_t));
+}
+
+void bitset_fill(Bitset *bitset) {
+  size_t words_number = bitset_words_number(bitset);
+  memset(bitset->data, 0xFF, words_number * sizeof(uint64_t));
+  bitset->data[words_number - 1] = (1ULL << (bitset->size % BITS)) - 1;
+}
+
+void bitset_copy_bits(Bitset *dst, size_t dst_i, Bitset *src, size_t src_i,
+                      size_t n) {
+  while (n > 0) {
+    size_t length = n < BITS ? n : BITS;
+    write_bits(dst, dst_i, read_bits(src, src_i, length), length);
+    dst_i += length;
+    src_i += length;
+    n -= length;
+  }
+}
+
+uint64_t bitset_read_bits(Bitset *bitset, size_t i, size_t n) {
+  return read_bits(bitset, i, n);
+}
+
+// Checks if any of bits [begin, end) of a compressed bitset is set.
+// Chunks without set bits are skipped as a whole.
+static bool any_compressed(Bitset *bitset, size_t begin, size_t end) {
+  for (size_t c = begin / CHUNK_BITS; c * CHUNK_BITS < end; c++) {
+    Container *container = &bitset->containers[c];
+    size_t chunk_begin = c * CHUNK_BITS, chunk_end = chunk_begin + CHUNK_BITS;
+    if (container->cardinality == 0) {
+      continue;
+    }
+    if (begin <= chunk_begin && chunk_end <= end) {
+      return true;
+    }
+
+    size_t first = begin > chunk_begin ? begin : chunk_begin;
+    size_t last = (end < chunk_end ? end : chunk_end) - 1;
+    for (size_t w = first / BITS; w <= last / BITS; w++) {
+      uint64_t word = container_word(container, w % CHUNK_WORDS);
+      if (w == first / BITS) {
+        word &= UINT64_MAX << (first % BITS);
+      }
+      if (w == last / BITS) {
+        word &= UINT64_MAX >> (BITS - 1 - last % BITS);
+      }
+      if (word != 0) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+// Checks if any of bits [begin, end) of the stored words is set. Assumes
+// that begin < end.
+static bool any_stored(Bitset *bitset, size_t begin, size_t end) {
+  if (bitset->containers != NULL) {
+    return any_compressed(bitset, begin, end);
+  }
+
+  size_t first = begin / BITS, last = (end - 1) / BITS;
+  uint64_t first_mask = UINT64_MAX << (begin % BITS);
+  uint64_t last_mask = UINT64_MAX >> (BITS - 1 - (end - 1) % BITS);
+  if (first == last) {
+    return (bitset->data[first] & first_mask & last_mask) != 0;
+  }
+
+  if (bitset->data[first] & first_mask) {
+    return true;
+  }
+  for (size_t w = first + 1; w < last; w++) {
+    if (bitset->data[w] != 0) {
+      return true;
+    }
+  }
+
+  return (bitset->data[last] & last_mask) != 0;
+}
+
+bool bitset_any(Bitset *bitset, size_t begin, size_t end) {
+  if (begin >= end) {
+    return false;
+  }
+  if (!bitset_is_periodic(bitset)) {
+    return any_stored(bitset, begin, end);
+  }
+
+  // a range of at least one period covers every stored bit
+  size_t period = bitset->mask + 1;
+  if (end - begin >= period) {
+    return any_stored(bitset, 0, period);
+  }
+
+  size_t length = end - begin;
+  begin &= bitset->mask;
+  end = begin + length;
+  if (end <= period) {
+    return any_stored(bitset, begin, end);
+  }
+
+  return any_stored(bitset, begin, period) ||
+         any_stored(bitset, 0, end - period);
+}
+
+size_t bitset_count(Bitset *bitset) {
+  size_t count = 0;
+  if (bitset->containers != NULL) {
+    for (size_t c = 0; c < chunks_number(bitset); c++) {
+      count += bitset->containers[c].cardinality;
+    }
+
+    return count;
+  }
+
+  for (size_t i = 0; i < bitset_words_number(bitset); i++) {
+    count += (size_t)__builtin_popcountll(bitset->data[i]);
+  }
+
+  return count;
+}
+
+double bitset_density(Bitset *bitset) {
+  size_t stored_size =
+      bitset_is_periodic(bitset) ? bitset->mask + 1 : bitset->size;
+
+  return stored_size > 0 ? (double)bitset_count(bitset) / (double)stored_size
+                         : 0;
+}
+
+bool bitset_test_and_set(Bitset *bitset, size_t i) {
+  uint64_t n = i / BITS;
+  uint64_t mask = 1ULL << (i % BITS);
+
+  // cheap check first, so already set bits don't need a locked instruction
+  if (__atomic_load_n(&bitset->data[n], __ATOMIC_RELAXED) & mask) {
+    return true;
+  }
+
+  uint64_t old = __atomic_fetch_or(&bitset->data[n], mask, __ATOMIC_RELAXED);
+
+  return (old & mask) > 0;
+}
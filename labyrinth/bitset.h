@@ -3,17 +3,53 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include "vector.h"
 
 typedef struct Bitset Bitset;
 
-// Creates empty (filled with zeros) bitset with given size.
+// Decoder of a hexadecimal number whose digits arrive in parts.
+typedef struct HexStream HexStream;
+
+// Creates empty (filled with zeros) bitset with given size. Pages of
+// large bitsets are committed only when they're written for the first
+// time.
 Bitset* bitset_create(size_t size);
 
-// Creates bitset from a string, which represents either a hexadecimal
-// number or a generator, and returns it. If it's incorrect or it tries
-// to set bit >= size, returns NULL.
-Bitset* bitset_create_from_string(char* str, size_t size);
+// Returns empty bitset with given size. Memory of passed bitset, which
+// may be NULL, is cleared and reused if it's large enough, and freed
+// otherwise. Bitsets which are compressed or mapped from a file aren't
+// reused.
+Bitset* bitset_recreate(Bitset* bitset, size_t size);
+
+// Creates bitset with given size from words stored in file fd from given
+// offset, which must be a multiple of page size, in the layout of
+// bitset_data. Words of a periodic bitset hold its first 2^32 bits only.
+// The file is mapped privately, so it isn't changed by writes to bitset,
+// and its pages are read only when they're accessed. Returns NULL if the
+// file can't be mapped or any bit past the stored ones is set.
+Bitset* bitset_map_file(int fd, size_t offset, size_t size, bool periodic);
+
+// Creates bitset from a string, which represents a generator, and returns
+// it. If it's incorrect or it tries to set bit >= size, returns NULL.
+// Bitsets of generators with size of at least 2^36 are periodic.
+// Hexadecimal numbers are decoded with a HexStream instead. Memory of
+// reused bitset, which may be NULL, is used as in bitset_recreate.
+Bitset* bitset_create_from_string(char* str, size_t size, Bitset* reused);
+
+// Starts decoding digits of a hexadecimal number (without 0x prefix)
+// into a bitset with given size, made from reused one (which may be
+// NULL) as in bitset_recreate.
+HexStream* bitset_hex_stream_create(size_t size, Bitset* reused);
+
+// Decodes digits from the beginning of chars. Returns number of decoded
+// characters, which is smaller than n if a character that isn't
+// a hexadecimal digit was found.
+size_t bitset_hex_stream_feed(HexStream* stream, const char* chars, size_t n);
+
+// Frees stream and returns decoded bitset. If there were no digits or
+// the number has bit >= size set, returns NULL.
+Bitset* bitset_hex_stream_finish(HexStream* stream);
 
 // Frees all allocated memory of passed bitset.
 void bitset_free(Bitset* bitset);
@@ -22,7 +58,73 @@ void bitset_free(Bitset* bitset);
 // Otherwise, returns false.
 bool bitset_set(Bitset* bitset, size_t i);
 
-// Checks if i-th bit is set.
+// Unsets i-th bit of bitset. Assumes that i < bitset size.
+void bitset_unset(Bitset* bitset, size_t i);
+
+// Checks if i-th bit is set. Works for periodic bitsets too.
 bool bitset_get(Bitset* bitset, size_t i);
 
+// Returns number of bits of bitset.
+size_t bitset_size(Bitset* bitset);
+
+// Returns pointer to the words of bitset. Bit i is stored in word i / 64
+// as its (i % 64)-th least significant bit. Bits >= bitset size are 0.
+// Words of a periodic bitset hold its first period only. Compressed
+// bitsets have no words, so it returns NULL for them.
+uint64_t* bitset_data(Bitset* bitset);
+
+// Returns number of words of bitset.
+size_t bitset_words_number(Bitset* bitset);
+
+// Checks if bitset is periodic, i.e. it stores only its first 2^32 bits,
+// which repeat up to its size. Such bitset can only be read with
+// bitset_get.
+bool bitset_is_periodic(Bitset* bitset);
+
+// Compresses bitset if that divides its memory at least by 2. Every
+// chunk of 2^16 bits is stored as a sorted array of set bits, a list of
+// runs of set bits or a bitmap, whichever is the smallest. Compressed
+// bitset can only be read: with bitset_get, bitset_word, bitset_any,
+// bitset_read_bits, bitset_count and as the source of bitset_copy_bits.
+// Returns true if bitset is compressed.
+bool bitset_compress(Bitset* bitset);
+
+// Checks if bitset is compressed.
+bool bitset_is_compressed(Bitset* bitset);
+
+// Returns w-th word of bitset, as in bitset_data. Works for compressed
+// bitsets too. Assumes that w < bitset_words_number(bitset).
+uint64_t bitset_word(Bitset* bitset, size_t w);
+
+// Unsets all bits.
+void bitset_clear(Bitset* bitset);
+
+// Sets all bits.
+void bitset_fill(Bitset* bitset);
+
+// Copies n bits of src starting from src_i-th to dst starting from
+// dst_i-th. Assumes that both ranges fit in the bitsets.
+void bitset_copy_bits(Bitset* dst, size_t dst_i, Bitset* src, size_t src_i,
+                      size_t n);
+
+// Returns n <= 64 bits of bitset starting from i-th as the least
+// significant bits of a word. Assumes that i + n <= bitset size and
+// bitset isn't periodic.
+uint64_t bitset_read_bits(Bitset* bitset, size_t i, size_t n);
+
+// Checks if any of bits [begin, end) is set, scanning whole words. Works
+// for periodic bitsets too. Assumes that end <= bitset size.
+bool bitset_any(Bitset* bitset, size_t begin, size_t end);
+
+// Returns number of set bits.
+size_t bitset_count(Bitset* bitset);
+
+// Returns fraction of bits which are set. For a periodic bitset, it's
+// computed over its first period.
+double bitset_density(Bitset* bitset);
+
+// Atomically sets i-th bit and returns its previous value. Safe to call
+// concurrently from many threads. Assumes that i < bitset size.
+bool bitset_test_and_set(Bitset* bitset, size_t i);
+
 #endif  // BITSET_H
@@ -0,0 +1,366 @@
+#include "components.h"
+#include <stdio.h>
+#include <string.h>
+#include "bitset.h"
+#include "parallel.h"
+#include "utils.h"
+
+#define BITS 64
+
+// Version of the file format.
+#define VERSION 1
+
+// Number of 64-bit header fields other than dimensions.
+#define HEADER_FIELDS 5
+
+struct Components {
+  size_t dimensions_number;
+  uint64_t *dimensions;
+  uint64_t walls_checksum;
+  // bit of every position which starts a run
+  Bitset *run_starts;
+  // number of runs which start in words before every word of run_starts
+  size_t *ranks;
+  size_t runs_number;
+  // component of every run, i.e. the first run connected to it
+  size_t *labels;
+};
+
+// Maze shared by threads that label its components.
+typedef struct {
+  Maze *maze;
+  Components *components;
+  // parent of every run in union-find, always an earlier run
+  size_t *parents;
+  size_t threads;
+} Labelling;
+
+// Returns a checksum of words of walls.
+static uint64_t walls_checksum(Bitset *walls) {
+  uint64_t *data = bitset_data(walls);
+  uint64_t checksum = 14695981039346656037ULL;
+  for (size_t w = 0; w < bitset_words_number(walls); w++) {
+    checksum = (checksum ^ data[w]) * 1099511628211ULL;
+  }
+
+  return checksum;
+}
+
+// Returns number of run of free position with given hash.
+static size_t run_number(Components *components, size_t position_hash) {
+  size_t w = position_hash / BITS;
+  uint64_t below = UINT64_MAX >> (BITS - 1 - position_hash % BITS);
+
+  return components->ranks[w] +
+         (size_t)__builtin_popcountll(bitset_data(components->run_starts)[w] &
+                                      below) -
+         1;
+}
+
+// Finds root of run x, halving the path to it.
+static size_t find(size_t *parents, size_t x) {
+  size_t parent;
+  while ((parent = __atomic_load_n(&parents[x], __ATOMIC_RELAXED)) != x) {
+    size_t grandparent = __atomic_load_n(&parents[parent], __ATOMIC_RELAXED);
+    if (grandparent != parent) {
+      // ancestors only get earlier, so a stale value is still an ancestor
+      __atomic_store_n(&parents[x], grandparent, __ATOMIC_RELAXED);
+    }
+    x = grandparent;
+  }
+
+  return x;
+}
+
+// Joins components of runs a and b. The later root is linked to the
+// earlier one, retrying if another thread has linked it meanwhile.
+static void unite(size_t *parents, size_t a, size_t b) {
+  while (true) {
+    a = find(parents, a);
+    b = find(parents, b);
+    if (a == b) {
+      return;
+    }
+    if (a < b) {
+      size_t temp = a;
+      a = b;
+      b = temp;
+    }
+
+    size_t expected = a;
+    if (__atomic_compare_exchange_n(&parents[a], &expected, b, false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+      return;
+    }
+  }
+}
+
+// Marks starts of runs in id-th part of words. A free position starts
+// a run if it starts a row of the first dimension or follows a wall.
+static void mark_run_starts(void *labelling_ptr, size_t id) {
+  Labelling *labelling = (Labelling *)labelling_ptr;
+  Maze *maze = labelling->maze;
+  size_t size = maze_size(maze), row_length = maze_dimension(maze, 0);
+  uint64_t *walls = bitset_data(maze_walls(maze));
+  uint64_t *starts = bitset_data(labelling->components->run_starts);
+  size_t words = bitset_words_number(labelling->components->run_starts);
+  size_t begin = words * id / labelling->threads;
+  size_t end = words * (id + 1) / labelling->threads;
+
+  for (size_t w = begin; w < end; w++) {
+    uint64_t free = ~walls[w];
+    if (w == size / BITS) {
+      free &= (1ULL << (size % BITS)) - 1;
+    }
+
+    // the previous position is free if it isn't a wall of previous word
+    uint64_t previous_free = free << 1;
+    if (w > 0) {
+      previous_free |= ~walls[w - 1] >> (BITS - 1);
+    }
+
+    uint64_t word = free & ~previous_free;
+    size_t first_row = (w * BITS + row_length - 1) / row_length * row_length;
+    for (size_t i = first_row; i < (w + 1) * BITS && i < size;
+         i += row_length) {
+      word |= free & (1ULL << (i % BITS));
+    }
+    starts[w] = word;
+  }
+}
+
+// Joins runs of rows, whose positions have hashes from a to a + length,
+// and the rows delta positions further, wherever both are free.
+static void join_rows(Labelling *labelling, size_t a, size_t delta,
+                      size_t length) {
+  Bitset *walls = maze_walls(labelling->maze);
+  for (size_t offset = 0; offset < length; offset += BITS) {
+    size_t n = length - offset < BITS ? length - offset : BITS;
+    uint64_t both_free =
+        ~(bitset_read_bits(walls, a + offset, n) |
+          bitset_read_bits(walls, a + offset + delta, n));
+    if (n < BITS) {
+      both_free &= (1ULL << n) - 1;
+    }
+
+    // a single position of every common run is enough
+    uint64_t common_starts = both_free & ~(both_free << 1);
+    while (common_starts != 0) {
+      size_t position_hash = a + offset + __builtin_ctzll(common_starts);
+      unite(labelling->parents,
+            run_number(labelling->components, position_hash),
+            run_number(labelling->components, position_hash + delta));
+      common_starts &= common_starts - 1;
+    }
+  }
+}
+
+// Joins runs of id-th part of rows with runs of their successors in
+// every dimension other than the first.
+static void join_runs(void *labelling_ptr, size_t id) {
+  Labelling *labelling = (Labelling *)labelling_ptr;
+  Maze *maze = labelling->maze;
+  size_t k = maze_dimensions_number(maze);
+  size_t row_length = maze_dimension(maze, 0);
+  size_t rows_number = maze_size(maze) / row_length;
+  size_t begin = rows_number * id / labelling->threads;
+  size_t end = rows_number * (id + 1) / labelling->threads;
+
+  // coordinates of the current row in dimensions 1..k-1, counted from 0,
+  // and distances between hashes of neighbours in them
+  uint64_t *coordinates = (uint64_t *)safe_calloc(k, sizeof(uint64_t));
+  size_t *strides = (size_t *)safe_calloc(k, sizeof(size_t));
+  size_t rest = begin;
+  strides[0] = 1;
+  for (size_t i = 1; i < k; i++) {
+    strides[i] = strides[i - 1] * maze_dimension(maze, i - 1);
+    coordinates[i] = rest % maze_dimension(maze, i);
+    rest /= maze_dimension(maze, i);
+  }
+
+  for (size_t row = begin; row < end; row++) {
+    for (size_t i = 1; i < k; i++) {
+      if (coordinates[i] + 1 < maze_dimension(maze, i)) {
+        join_rows(labelling, row * row_length, strides[i], row_length);
+      }
+    }
+
+    // move to the next row
+    for (size_t i = 1; i < k; i++) {
+      if (++coordinates[i] < maze_dimension(maze, i)) {
+        break;
+      }
+      coordinates[i] = 0;
+    }
+  }
+
+  free(coordinates);
+  free(strides);
+}
+
+// Labels id-th part of runs with roots of their components.
+static void label_runs(void *labelling_ptr, size_t id) {
+  Labelling *labelling = (Labelling *)labelling_ptr;
+  Components *components = labelling->components;
+  size_t begin = components->runs_number * id / labelling->threads;
+  size_t end = components->runs_number * (id + 1) / labelling->threads;
+
+  for (size_t run = begin; run < end; run++) {
+    components->labels[run] = find(labelling->parents, run);
+  }
+}
+
+// Counts runs before every word of run starts.
+static void count_runs(Components *components) {
+  uint64_t *starts = bitset_data(components->run_starts);
+  size_t words = bitset_words_number(components->run_starts);
+  components->ranks = (size_t *)safe_calloc(words, sizeof(size_t));
+
+  size_t runs_number = 0;
+  for (size_t w = 0; w < words; w++) {
+    components->ranks[w] = runs_number;
+    runs_number += (size_t)__builtin_popcountll(starts[w]);
+  }
+  components->runs_number = runs_number;
+}
+
+// Creates components of maze without runs and labels.
+static Components *components_create_empty(Maze *maze) {
+  Components *components = (Components *)safe_calloc(1, sizeof(Components));
+  components->dimensions_number = maze_dimensions_number(maze);
+  components->dimensions = (uint64_t *)safe_calloc(
+      components->dimensions_number, sizeof(uint64_t));
+  for (size_t i = 0; i < components->dimensions_number; i++) {
+    components->dimensions[i] = maze_dimension(maze, i);
+  }
+  components->walls_checksum = walls_checksum(maze_walls(maze));
+  components->run_starts = bitset_create(maze_size(maze));
+
+  return components;
+}
+
+Components *components_create(Maze *maze) {
+  if (bitset_is_periodic(maze_walls(maze)) ||
+      bitset_is_compressed(maze_walls(maze))) {
+    return NULL;
+  }
+
+  Labelling labelling = {maze, components_create_empty(maze), NULL,
+                         parallel_threads()};
+  Components *components = labelling.components;
+  parallel_run(labelling.threads, mark_run_starts, &labelling);
+  count_runs(components);
+
+  labelling.parents =
+      (size_t *)safe_calloc(components->runs_number + 1, sizeof(size_t));
+  for (size_t run = 0; run < components->runs_number; run++) {
+    labelling.parents[run] = run;
+  }
+  parallel_run(labelling.threads, join_runs, &labelling);
+
+  components->labels =
+      (size_t *)safe_calloc(components->runs_number + 1, sizeof(size_t));
+  parallel_run(labelling.threads, label_runs, &labelling);
+  free(labelling.parents);
+
+  return components;
+}
+
+void components_free(Components *components) {
+  if (components != NULL) {
+    free(components->dimensions);
+    bitset_free(components->run_starts);
+    free(components->ranks);
+    free(components->labels);
+    free(components);
+  }
+}
+
+bool components_connected(Components *components, size_t position_hash1,
+                          size_t position_hash2) {
+  return components->labels[run_number(components, position_hash1)] ==
+         components->labels[run_number(components, position_hash2)];
+}
+
+bool components_save(Components *components, const char *path) {
+  FILE *file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+
+  size_t k = components->dimensions_number;
+  uint64_t header[HEADER_FIELDS] = {0, VERSION, k,
+                                    components->walls_checksum,
+                                    components->runs_number};
+  memcpy(&header[0], "LABCOMP", 8);
+
+  size_t words = bitset_words_number(components->run_starts);
+  bool written =
+      fwrite(header, sizeof(uint64_t), HEADER_FIELDS, file) ==
+          HEADER_FIELDS &&
+      fwrite(components->dimensions, sizeof(uint64_t), k, file) == k &&
+      fwrite(bitset_data(components->run_starts), sizeof(uint64_t), words,
+             file) == words &&
+      fwrite(components->labels, sizeof(size_t), components->runs_number,
+             file) == components->runs_number;
+
+  return fclose(file) == 0 && written;
+}
+
+// Checks if header and dimensions read from file match maze.
+static bool matches(Components *components, uint64_t *header,
+                    uint64_t *dimensions) {
+  if (memcmp(&header[0], "LABCOMP", 8) != 0 || header[1] != VERSION ||
+      header[2] != components->dimensions_number ||
+      header[3] != components->walls_checksum) {
+    return false;
+  }
+
+  return memcmp(dimensions, components->dimensions,
+                components->dimensions_number * sizeof(uint64_t)) == 0;
+}
+
+Components *components_load(Maze *maze, const char *path) {
+  if (bitset_is_periodic(maze_walls(maze)) ||
+      bitset_is_compressed(maze_walls(maze))) {
+    return NULL;
+  }
+
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
+  }
+
+  Components *components = components_create_empty(maze);
+  size_t k = components->dimensions_number;
+  uint64_t header[HEADER_FIELDS];
+  uint64_t *dimensions = (uint64_t *)safe_calloc(k, sizeof(uint64_t));
+  bool correct =
+      fread(header, sizeof(uint64_t), HEADER_FIELDS, file) == HEADER_FIELDS &&
+      fread(dimensions, sizeof(uint64_t), k, file) == k &&
+      matches(components, header, dimensions);
+  free(dimensions);
+
+  size_t words = bitset_words_number(components->run_starts);
+  correct = correct && fread(bitset_data(components->run_starts),
+                             sizeof(uint64_t), words, file) == words;
+  if (correct) {
+    count_runs(components);
+    correct = components->runs_number == header[4];
+  }
+  if (correct) {
+    components->labels = (size_t *)safe_calloc(components->runs_number + 1,
+                                               sizeof(size_t));
+    correct = fread(components->labels, sizeof(size_t),
+                    components->runs_number,
+                    file) == components->runs_number;
+  }
+  fclose(file);
+
+  if (!correct) {
+    components_free(components);
+    return NULL;
+  }
+
+  return components;
+}
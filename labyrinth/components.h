@@ -0,0 +1,36 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "maze.h"
+
+// Connected components of free positions of a maze. Free positions which
+// follow one another in the first dimension form runs, and every run is
+// labelled with its component.
+typedef struct Components Components;
+
+// Labels free positions of maze with their connected components. Runs of
+// adjacent rows are joined with a concurrent union-find, whose rows are
+// split between threads. Returns NULL if maze walls are periodic or
+// compressed. Maze isn't modified.
+Components *components_create(Maze *maze);
+
+// Frees all allocated memory of passed components.
+void components_free(Components *components);
+
+// Checks if free positions with given hashes belong to the same component.
+bool components_connected(Components *components, size_t position_hash1,
+                          size_t position_hash2);
+
+// Writes components to file with given path, together with dimensions
+// and checksum of walls of maze they were created for. Returns false if
+// it fails.
+bool components_save(Components *components, const char *path);
+
+// Reads components from file with given path. Returns NULL if it can't be
+// read, it was saved for a maze with other dimensions or walls or maze
+// walls are periodic or compressed.
+Components *components_load(Maze *maze, const char *path);
+
+#endif  // COMPONENTS_H
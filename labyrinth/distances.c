@@ -0,0 +1,295 @@
+#define _DEFAULT_SOURCE
+
+#include "distances.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "bitset.h"
+#include "frontier.h"
+#include "utils.h"
+#include "vector.h"
+
+// Version of the file format.
+#define VERSION 1
+
+// Number of 64-bit header fields other than dimensions.
+#define HEADER_FIELDS 7
+
+// File being written, mapped from its beginning. Values start after the
+// header and, with DISTANCES_LEVELS format, are moved behind the index
+// once the number of levels is known.
+typedef struct {
+  Bitset *visited;
+  int fd;
+  uint8_t *file;
+  size_t bytes;
+  size_t header_bytes;
+  size_t width;
+  // number of hashes of DISTANCES_LEVELS format
+  size_t next;
+} Output;
+
+// Resizes file of output to given number of bytes and maps it again.
+// Returns false if it fails.
+static bool remap(Output *output, size_t bytes) {
+  if (output->file != NULL) {
+    munmap(output->file, output->bytes);
+    output->file = NULL;
+  }
+
+  void *file = MAP_FAILED;
+  if (bytes < SIZE_MAX && ftruncate(output->fd, (off_t)bytes) == 0) {
+    file = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, output->fd,
+                0);
+  }
+  if (file == MAP_FAILED) {
+    return false;
+  }
+  output->file = (uint8_t *)file;
+  output->bytes = bytes;
+
+  return true;
+}
+
+// Stores value in width bytes at index i of data.
+static void store(uint8_t *data, size_t width, size_t i, uint64_t value) {
+  switch (width) {
+    case 1:
+      data[i] = (uint8_t)value;
+      break;
+    case 2:
+      ((uint16_t *)data)[i] = (uint16_t)value;
+      break;
+    case 4:
+      ((uint32_t *)data)[i] = (uint32_t)value;
+      break;
+    default:
+      ((uint64_t *)data)[i] = value;
+  }
+}
+
+// Returns the smallest number of bytes, 1, 2, 4 or 8, which holds
+// numbers up to max.
+static size_t value_width(uint64_t max) {
+  size_t width = 1;
+  while (width < 8 && max >> (8 * width) != 0) {
+    width *= 2;
+  }
+
+  return width;
+}
+
+// Loads value of width bytes at index i of data.
+static uint64_t load(const uint8_t *data, size_t width, size_t i) {
+  switch (width) {
+    case 1:
+      return data[i];
+    case 2:
+      return ((const uint16_t *)data)[i];
+    case 4:
+      return ((const uint32_t *)data)[i];
+    default:
+      return ((const uint64_t *)data)[i];
+  }
+}
+
+// Saves distance + 1 of position with given hash. Values of other
+// positions stay 0, as in a newly extended file. Once the distance
+// doesn't fit, values of visited positions are widened in place, from the
+// last one, so that none is overwritten before it's moved, and pages of
+// positions that can't be reached aren't written. Returns false if the
+// file can't be extended.
+static bool visit_map(Output *output, size_t position_hash, size_t depth) {
+  size_t width = value_width(depth + 1);
+  if (width > output->width) {
+    size_t values_number = (output->bytes - output->header_bytes) /
+                           output->width;
+    if (!remap(output, safe_sum(output->header_bytes,
+                                safe_product(values_number, width)))) {
+      return false;
+    }
+
+    uint8_t *data = output->file + output->header_bytes;
+    uint64_t *words = bitset_data(output->visited);
+    for (size_t w = bitset_words_number(output->visited); w-- > 0;) {
+      for (uint64_t word = words[w]; word != 0;) {
+        size_t bit = 63 - (size_t)__builtin_clzll(word);
+        word &= ~(1ULL << bit);
+
+        // the old value may lie in room of an earlier position
+        size_t i = w * 64 + bit;
+        uint64_t value = load(data, output->width, i);
+        store(data, output->width, i, 0);
+        store(data, width, i, value);
+      }
+    }
+    output->width = width;
+  }
+
+  store(output->file + output->header_bytes, output->width, position_hash,
+        depth + 1);
+
+  return true;
+}
+
+// Saves hash of position after the positions visited before it, doubling
+// the file when it's full. Returns false if the file can't be extended.
+static bool visit_levels(Output *output, size_t position_hash,
+                         size_t depth) {
+  (void)depth;
+  if (output->header_bytes + (output->next + 1) * output->width >
+          output->bytes &&
+      !remap(output, safe_product(output->bytes, 2))) {
+    return false;
+  }
+
+  store(output->file + output->header_bytes, output->width, output->next++,
+        position_hash);
+
+  return true;
+}
+
+// Visits positions reachable from start position level by level, in one
+// bfs that uses visited bitset of output and frontiers of maze, and calls
+// visit(output, position_hash, depth) for every one of them. Saves number
+// of positions of every level to level_sizes and end distance, or
+// SIZE_MAX if end position can't be reached, to end_distance. Returns
+// false if visit fails.
+static bool traverse(Maze *maze, Vector *level_sizes, size_t *end_distance,
+                     bool (*visit)(Output *, size_t, size_t),
+                     Output *output) {
+  size_t size = maze_size(maze);
+  Bitset *walls = maze_walls(maze);
+  Bitset *visited = output->visited;
+  size_t *neighbours = (size_t *)safe_calloc(
+      2 * maze_dimensions_number(maze), sizeof(size_t));
+
+  Frontier *current_depth_positions, *next_depth_positions;
+  maze_frontiers(maze, size, &current_depth_positions, &next_depth_positions);
+
+  // initialize bfs using start position
+  size_t start_position_hash = maze_start_position_hash(maze);
+  frontier_push(current_depth_positions, start_position_hash);
+  bitset_set(visited, start_position_hash);
+
+  size_t depth = 0, level_size = 0;
+  bool visited_all = true;
+  *end_distance = SIZE_MAX;
+  while (visited_all && !frontier_is_empty(current_depth_positions)) {
+    size_t position_hash = frontier_pop(current_depth_positions);
+    ++level_size;
+    visited_all = visit(output, position_hash, depth);
+    if (position_hash == maze_end_position_hash(maze)) {
+      *end_distance = depth;
+    }
+
+    size_t neighbours_number =
+        maze_neighbours(maze, position_hash, neighbours);
+    for (size_t j = 0; j < neighbours_number; j++) {
+      size_t next_position_hash = neighbours[j];
+      if (bitset_get(walls, next_position_hash) ||
+          bitset_get(visited, next_position_hash)) {
+        continue;
+      }
+
+      frontier_push(next_depth_positions, next_position_hash);
+      bitset_set(visited, next_position_hash);
+    }
+
+    // check if all positions of current depth were visited
+    if (frontier_is_empty(current_depth_positions)) {
+      vector_push_back(level_sizes, level_size);
+      level_size = 0;
+      ++depth;
+      swap((void **)&current_depth_positions, (void **)&next_depth_positions);
+    }
+  }
+
+  free(neighbours);
+
+  return visited_all;
+}
+
+bool distances_write(Maze *maze, const char *path, DistancesFormat format) {
+  size_t size = maze_size(maze);
+  size_t k = maze_dimensions_number(maze);
+
+  Output output = {.visited = maze_visited(maze, size),
+                   .fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644),
+                   .header_bytes = (HEADER_FIELDS + k) * sizeof(uint64_t)};
+  if (output.fd < 0) {
+    return false;
+  }
+
+  // distances start in 1 byte each and are widened when they grow, while
+  // hashes are written in room that grows from one block of 64 KiB
+  bool written;
+  if (format == DISTANCES_MAP) {
+    output.width = 1;
+    written = remap(&output, safe_sum(output.header_bytes, size));
+  } else {
+    output.width = size <= (1ULL << 32) ? 4 : 8;
+    written = remap(&output, output.header_bytes + (1 << 16));
+  }
+
+  Vector *level_sizes = vector_create();
+  size_t end_distance = SIZE_MAX;
+  written = written &&
+            traverse(maze, level_sizes, &end_distance,
+                     format == DISTANCES_MAP ? visit_map : visit_levels,
+                     &output);
+  size_t levels_number = vector_size(level_sizes);
+
+  if (written && format == DISTANCES_LEVELS) {
+    // move hashes behind index of the first position of every level and
+    // after the last one
+    size_t index_bytes = (levels_number + 1) * sizeof(uint64_t);
+    size_t hashes_bytes = output.next * output.width;
+    size_t bytes = output.header_bytes + index_bytes + hashes_bytes;
+    written = remap(&output, bytes > output.bytes ? bytes : output.bytes);
+    if (written) {
+      uint8_t *hashes = output.file + output.header_bytes;
+      memmove(hashes + index_bytes, hashes, hashes_bytes);
+
+      uint64_t *index = (uint64_t *)hashes;
+      index[0] = 0;
+      for (size_t i = 0; i < levels_number; i++) {
+        index[i + 1] = index[i] + vector_get(level_sizes, i);
+      }
+      written = remap(&output, bytes);
+    }
+  }
+
+  if (written) {
+    uint64_t *header = (uint64_t *)output.file;
+    memcpy(header++, "LABDIST", 8);
+    *header++ = VERSION;
+    *header++ = format;
+    *header++ = output.width;
+    *header++ = k;
+    for (size_t i = 0; i < k; i++) {
+      *header++ = maze_dimension(maze, i);
+    }
+    *header++ = maze_start_position_hash(maze);
+    *header++ = levels_number;
+  }
+
+  if (output.file != NULL && munmap(output.file, output.bytes) != 0) {
+    written = false;
+  }
+  close(output.fd);
+  vector_free(level_sizes);
+  if (!written) {
+    return false;
+  }
+
+  if (end_distance != SIZE_MAX) {
+    printf("%zu\n", end_distance);
+  } else {
+    printf("NO WAY\n");
+  }
+
+  return true;
+}
@@ -0,0 +1,30 @@
+#ifndef DISTANCES_H
+#define DISTANCES_H
+
+#include <stdbool.h>
+#include "maze.h"
+
+// Formats of files with distances from start position.
+typedef enum {
+  // value of every maze position, in order of hashes: distance + 1 for
+  // reachable positions and 0 for others, in 1, 2, 4 or 8 bytes, whichever
+  // is the smallest to fit the largest distance
+  DISTANCES_MAP,
+  // hashes of reachable positions level by level, in 4 bytes if maze has
+  // at most 2^32 positions and 8 bytes otherwise, after index of the
+  // first position of every level
+  DISTANCES_LEVELS,
+} DistancesFormat;
+
+// Finds distances from start position to every reachable position with
+// one bfs, which runs until all of them are visited, using visited bitset
+// and frontiers of maze, and writes them to file with given path in given
+// format as they're found. The file starts with a header of
+// 64-bit numbers in native byte order: magic "LABDIST\0", version (1),
+// format, bytes of one value, number of dimensions, dimensions, hash of
+// start position and number of levels. Afterwards, like maze_solve,
+// prints length of the shortest path to end position or NO WAY. Returns
+// false if the file can't be written. Doesn't modify maze walls.
+bool distances_write(Maze *maze, const char *path, DistancesFormat format);
+
+#endif  // DISTANCES_H
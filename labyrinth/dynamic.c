@@ -0,0 +1,287 @@
+#include "dynamic.h"
+#include <string.h>
+#include "bitset.h"
+#include "frontier.h"
+#include "utils.h"
+#include "vector.h"
+
+// Distance of positions which can't be reached.
+#define UNREACHABLE UINT32_MAX
+
+struct DynamicMaze {
+  Maze *maze;
+  Bitset *walls;
+  // distance of every position from start position
+  uint32_t *distances;
+  // positions whose distance is increased by the latest wall
+  Bitset *affected;
+  // buffers for neighbours of two positions at once
+  size_t *neighbours;
+  size_t *next_neighbours;
+};
+
+// Finds distances of all positions with bfs.
+static void find_distances(DynamicMaze *dynamic) {
+  size_t size = maze_size(dynamic->maze);
+  Frontier *current_depth_positions = frontier_create(size);
+  Frontier *next_depth_positions = frontier_create(size);
+
+  // initialize bfs using start position
+  size_t start_position_hash = maze_start_position_hash(dynamic->maze);
+  frontier_push(current_depth_positions, start_position_hash);
+  dynamic->distances[start_position_hash] = 0;
+
+  uint32_t depth = 0;
+  while (!frontier_is_empty(current_depth_positions)) {
+    size_t position_hash = frontier_pop(current_depth_positions);
+
+    size_t neighbours_number =
+        maze_neighbours(dynamic->maze, position_hash, dynamic->neighbours);
+    for (size_t j = 0; j < neighbours_number; j++) {
+      size_t next_position_hash = dynamic->neighbours[j];
+      if (bitset_get(dynamic->walls, next_position_hash) ||
+          dynamic->distances[next_position_hash] != UNREACHABLE) {
+        continue;
+      }
+
+      dynamic->distances[next_position_hash] = depth + 1;
+      frontier_push(next_depth_positions, next_position_hash);
+    }
+
+    // check if all positions of current depth were visited
+    if (frontier_is_empty(current_depth_positions)) {
+      ++depth;
+      swap((void **)&current_depth_positions, (void **)&next_depth_positions);
+    }
+  }
+
+  frontier_free(current_depth_positions);
+  frontier_free(next_depth_positions);
+}
+
+// Returns 1 + the smallest distance of a free neighbour of position, or
+// UNREACHABLE if none of them can be reached.
+static uint32_t distance_through_neighbours(DynamicMaze *dynamic,
+                                            size_t position_hash) {
+  uint32_t distance = UNREACHABLE;
+  size_t neighbours_number =
+      maze_neighbours(dynamic->maze, position_hash, dynamic->neighbours);
+  for (size_t j = 0; j < neighbours_number; j++) {
+    uint32_t neighbour_distance = dynamic->distances[dynamic->neighbours[j]];
+    if (!bitset_get(dynamic->walls, dynamic->neighbours[j]) &&
+        neighbour_distance != UNREACHABLE &&
+        neighbour_distance + 1 < distance) {
+      distance = neighbour_distance + 1;
+    }
+  }
+
+  return distance;
+}
+
+// Lowers distances of free neighbours of position which are more than 1
+// larger and adds them to queue.
+static void relax_neighbours(DynamicMaze *dynamic, size_t position_hash,
+                             Vector *queue) {
+  uint32_t distance = dynamic->distances[position_hash] + 1;
+  size_t neighbours_number =
+      maze_neighbours(dynamic->maze, position_hash, dynamic->neighbours);
+  for (size_t j = 0; j < neighbours_number; j++) {
+    size_t next_position_hash = dynamic->neighbours[j];
+    if (!bitset_get(dynamic->walls, next_position_hash) &&
+        dynamic->distances[next_position_hash] > distance) {
+      dynamic->distances[next_position_hash] = distance;
+      vector_push_back(queue, next_position_hash);
+    }
+  }
+}
+
+// Lowers distances of positions reachable from seeds, whose distances are
+// already lowered. Seeds must be sorted by distance. Positions are taken
+// from seeds and the queue of lowered positions in order of distance, so
+// every position is expanded once, like in bfs.
+static void propagate(DynamicMaze *dynamic, Vector *seeds) {
+  Vector *queue = vector_create();
+  size_t seed = 0, head = 0;
+  while (seed < vector_size(seeds) || head < vector_size(queue)) {
+    size_t position_hash;
+    if (head == vector_size(queue) ||
+        (seed < vector_size(seeds) &&
+         dynamic->distances[vector_get(seeds, seed)] <=
+             dynamic->distances[vector_get(queue, head)])) {
+      position_hash = vector_get(seeds, seed++);
+    } else {
+      position_hash = vector_get(queue, head++);
+    }
+
+    relax_neighbours(dynamic, position_hash, queue);
+  }
+
+  vector_free(queue);
+}
+
+// Checks if position has a free neighbour which isn't affected and is 1
+// closer to start position.
+static bool is_supported(DynamicMaze *dynamic, size_t position_hash) {
+  uint32_t distance = dynamic->distances[position_hash];
+  size_t neighbours_number = maze_neighbours(dynamic->maze, position_hash,
+                                             dynamic->next_neighbours);
+  for (size_t j = 0; j < neighbours_number; j++) {
+    size_t neighbour = dynamic->next_neighbours[j];
+    if (!bitset_get(dynamic->walls, neighbour) &&
+        !bitset_get(dynamic->affected, neighbour) &&
+        dynamic->distances[neighbour] + 1 == distance) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Finds positions whose all shortest paths lead through the new wall at
+// given position and saves them to affected, with the wall itself.
+// Candidates are children of affected positions, taken in order of
+// distance, so that their parents are decided first.
+static void find_affected(DynamicMaze *dynamic, size_t wall_hash,
+                          Vector *affected) {
+  Vector *candidates = vector_create();
+  vector_push_back(candidates, wall_hash);
+
+  for (size_t head = 0; head < vector_size(candidates); head++) {
+    size_t position_hash = vector_get(candidates, head);
+    if (bitset_get(dynamic->affected, position_hash) ||
+        (position_hash != wall_hash && is_supported(dynamic, position_hash))) {
+      continue;
+    }
+
+    bitset_set(dynamic->affected, position_hash);
+    vector_push_back(affected, position_hash);
+
+    uint32_t child_distance = dynamic->distances[position_hash] + 1;
+    size_t neighbours_number =
+        maze_neighbours(dynamic->maze, position_hash, dynamic->neighbours);
+    for (size_t j = 0; j < neighbours_number; j++) {
+      size_t child = dynamic->neighbours[j];
+      if (!bitset_get(dynamic->walls, child) &&
+          dynamic->distances[child] == child_distance) {
+        vector_push_back(candidates, child);
+      }
+    }
+  }
+
+  vector_free(candidates);
+}
+
+// Compares numbers for qsort.
+static int compare(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+// Repairs distances after free position with given hash became a wall.
+// Affected positions lose their distance and take it again from their
+// neighbours that aren't affected, and from each other.
+static void add_wall(DynamicMaze *dynamic, size_t position_hash) {
+  bitset_set(dynamic->walls, position_hash);
+  if (dynamic->distances[position_hash] == UNREACHABLE) {
+    return;
+  }
+
+  Vector *affected = vector_create();
+  find_affected(dynamic, position_hash, affected);
+  for (size_t i = 0; i < vector_size(affected); i++) {
+    dynamic->distances[vector_get(affected, i)] = UNREACHABLE;
+  }
+
+  // seeds are sorted by distance, kept in higher bits with hash below
+  Vector *seeds = vector_create();
+  for (size_t i = 0; i < vector_size(affected); i++) {
+    size_t hash = vector_get(affected, i);
+    bitset_unset(dynamic->affected, hash);
+    if (hash == position_hash) {
+      continue;
+    }
+
+    uint32_t distance = distance_through_neighbours(dynamic, hash);
+    if (distance != UNREACHABLE) {
+      dynamic->distances[hash] = distance;
+      vector_push_back(seeds, (uint64_t)distance << 32 | hash);
+    }
+  }
+  qsort(vector_data(seeds), vector_size(seeds), sizeof(uint64_t), compare);
+  for (size_t i = 0; i < vector_size(seeds); i++) {
+    vector_data(seeds)[i] &= UINT32_MAX;
+  }
+
+  propagate(dynamic, seeds);
+
+  vector_free(seeds);
+  vector_free(affected);
+}
+
+// Repairs distances after wall at given position became free. Only
+// distances through it can get lower.
+static void remove_wall(DynamicMaze *dynamic, size_t position_hash) {
+  bitset_unset(dynamic->walls, position_hash);
+
+  uint32_t distance = distance_through_neighbours(dynamic, position_hash);
+  dynamic->distances[position_hash] = distance;
+  if (distance != UNREACHABLE) {
+    Vector *seeds = vector_create();
+    vector_push_back(seeds, position_hash);
+    propagate(dynamic, seeds);
+    vector_free(seeds);
+  }
+}
+
+DynamicMaze *dynamic_create(Maze *maze) {
+  size_t size = maze_size(maze);
+  if (bitset_is_periodic(maze_walls(maze)) || size >= UNREACHABLE) {
+    return NULL;
+  }
+
+  DynamicMaze *dynamic = (DynamicMaze *)safe_malloc(sizeof(DynamicMaze));
+  dynamic->maze = maze;
+  dynamic->walls = maze_walls(maze);
+  dynamic->distances = (uint32_t *)safe_malloc(size * sizeof(uint32_t));
+  memset(dynamic->distances, 0xFF, size * sizeof(uint32_t));
+  dynamic->affected = bitset_create(size);
+  dynamic->neighbours = (size_t *)safe_calloc(
+      2 * maze_dimensions_number(maze), sizeof(size_t));
+  dynamic->next_neighbours = (size_t *)safe_calloc(
+      2 * maze_dimensions_number(maze), sizeof(size_t));
+
+  find_distances(dynamic);
+
+  return dynamic;
+}
+
+void dynamic_free(DynamicMaze *dynamic) {
+  if (dynamic != NULL) {
+    free(dynamic->distances);
+    bitset_free(dynamic->affected);
+    free(dynamic->neighbours);
+    free(dynamic->next_neighbours);
+    free(dynamic);
+  }
+}
+
+bool dynamic_toggle_wall(DynamicMaze *dynamic, size_t position_hash) {
+  if (position_hash == maze_start_position_hash(dynamic->maze)) {
+    return false;
+  }
+
+  if (bitset_get(dynamic->walls, position_hash)) {
+    remove_wall(dynamic, position_hash);
+  } else {
+    add_wall(dynamic, position_hash);
+  }
+
+  return true;
+}
+
+size_t dynamic_path_length(DynamicMaze *dynamic) {
+  uint32_t distance =
+      dynamic->distances[maze_end_position_hash(dynamic->maze)];
+
+  return distance != UNREACHABLE ? distance : MAZE_NO_WAY;
+}
@@ -0,0 +1,30 @@
+#ifndef DYNAMIC_H
+#define DYNAMIC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "maze.h"
+
+// Maze whose walls change, with distances from start position to every
+// position kept up to date. A change repairs distances only of positions
+// around the toggled one whose distance it changes.
+typedef struct DynamicMaze DynamicMaze;
+
+// Creates dynamic maze from maze and finds all distances with bfs. Maze
+// isn't owned, but its walls are toggled by dynamic_toggle_wall. Returns
+// NULL if walls are periodic or maze has 2^32 positions or more.
+DynamicMaze *dynamic_create(Maze *maze);
+
+// Frees all allocated memory of passed dynamic maze, except for maze.
+void dynamic_free(DynamicMaze *dynamic);
+
+// Turns position with given hash into a wall if it's free or into a free
+// position otherwise, and repairs distances. Start position can't be
+// toggled, so returns false for it and true otherwise.
+bool dynamic_toggle_wall(DynamicMaze *dynamic, size_t position_hash);
+
+// Returns length of the shortest path from start to end position or
+// MAZE_NO_WAY if it doesn't exist.
+size_t dynamic_path_length(DynamicMaze *dynamic);
+
+#endif  // DYNAMIC_H
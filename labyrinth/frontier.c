@@ -0,0 +1,515 @@
+#define _DEFAULT_SOURCE
+
+#include "frontier.h"
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include "bitset.h"
+#include "utils.h"
+
+// Number of bytes of hashes stored in one block.
+#define BLOCK_BYTES (1 << 16)
+
+// Number of blocks a frontier may take under any memory limit: one is
+// filled with merged hashes of spilled runs, while the others buffer them.
+#define MIN_BLOCKS 3
+
+typedef struct Block {
+  struct Block *next;
+  size_t used;
+  unsigned char data[BLOCK_BYTES];
+} Block;
+
+// Sorted hashes written to the spill file.
+typedef struct Run {
+  // file offset and number of hashes not read yet
+  off_t offset;
+  size_t unread;
+  // block with hashes read, from data[next] to data[used], while merged
+  Block *buffer;
+  size_t next;
+  // hash at data[next]
+  size_t head;
+} Run;
+
+// Limit of memory of blocks of frontiers created afterwards.
+static size_t memory_limit = SIZE_MAX;
+
+struct Frontier {
+  size_t size;
+  size_t hash_bytes;
+  size_t hashes_per_block;
+  size_t hashes_number;
+
+  // stack of blocks with hashes, only the top one may be partially filled
+  Block *blocks;
+  // empty blocks kept for the next levels
+  Block *spare_blocks;
+  size_t blocks_number;
+
+  // used instead of blocks when dense is true, filled with zeros otherwise
+  Bitset *bitmap;
+  bool dense;
+  // bitmap words before this one are zero
+  size_t first_word;
+
+  size_t memory_limit;
+  // file with sorted runs of blocks over memory limit, -1 if there's none
+  // yet
+  int spill_fd;
+  off_t spill_bytes;
+  // runs before first_run are already merged into later ones
+  Run *runs;
+  size_t runs_number;
+  size_t runs_capacity;
+  size_t first_run;
+  // number of runs from first_run on merged into blocks popped, ordered as
+  // a binary min-heap of their heads
+  size_t merged_runs;
+  // hash merged last, SIZE_MAX before the first one
+  size_t last_merged;
+};
+
+// Frees all blocks of a list.
+static void free_blocks(Block *block) {
+  while (block != NULL) {
+    Block *next = block->next;
+    free(block);
+    block = next;
+  }
+}
+
+// Takes a spare block of frontier, or allocates a new one if there's none.
+static Block *take_block(Frontier *frontier) {
+  Block *block = frontier->spare_blocks;
+  if (block != NULL) {
+    frontier->spare_blocks = block->next;
+  } else {
+    block = (Block *)safe_malloc(sizeof(Block));
+    ++frontier->blocks_number;
+  }
+
+  return block;
+}
+
+// Keeps empty block for later.
+static void keep_block(Frontier *frontier, Block *block) {
+  block->next = frontier->spare_blocks;
+  frontier->spare_blocks = block;
+}
+
+// Returns i-th hash stored in data.
+static size_t read_hash(Frontier *frontier, const unsigned char *data,
+                        size_t i) {
+  if (frontier->hash_bytes == 4) {
+    uint32_t value;
+    memcpy(&value, &data[i * 4], 4);
+    return value;
+  }
+
+  uint64_t value;
+  memcpy(&value, &data[i * 8], 8);
+  return value;
+}
+
+// Stores hash as i-th one in data.
+static void write_hash(Frontier *frontier, unsigned char *data, size_t i,
+                       size_t hash) {
+  if (frontier->hash_bytes == 4) {
+    uint32_t value = (uint32_t)hash;
+    memcpy(&data[i * 4], &value, 4);
+  } else {
+    uint64_t value = hash;
+    memcpy(&data[i * 8], &value, 8);
+  }
+}
+
+// Moves all hashes from blocks to the bitmap and frees the blocks.
+static void switch_to_bitmap(Frontier *frontier) {
+  if (frontier->bitmap == NULL) {
+    frontier->bitmap = bitset_create(frontier->size);
+  }
+
+  // hashes repeated in spilled runs are dropped while they're popped
+  size_t hashes_number = 0;
+  while (!frontier_is_empty(frontier)) {
+    size_t hash = frontier_pop(frontier);
+    if (!bitset_get(frontier->bitmap, hash)) {
+      bitset_set(frontier->bitmap, hash);
+      ++hashes_number;
+    }
+  }
+
+  free_blocks(frontier->spare_blocks);
+  frontier->spare_blocks = NULL;
+  frontier->blocks_number = 0;
+
+  frontier->hashes_number = hashes_number;
+  frontier->dense = true;
+  frontier->first_word = 0;
+}
+
+// Compares 32-bit hashes for qsort.
+static int compare_hashes32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return (x > y) - (x < y);
+}
+
+// Compares 64-bit hashes for qsort.
+static int compare_hashes64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+// Opens spill file of frontier, unlinked at once, so that it disappears
+// when it's closed. On failure, calls error with code 0.
+static void open_spill_file(Frontier *frontier) {
+  const char *directory = getenv("TMPDIR");
+  if (directory == NULL || *directory == '\0') {
+    directory = "/tmp";
+  }
+
+  size_t length = strlen(directory) + sizeof("/labyrinth-XXXXXX");
+  char *path = (char *)safe_malloc(length);
+  snprintf(path, length, "%s/labyrinth-XXXXXX", directory);
+  frontier->spill_fd = mkstemp(path);
+  if (frontier->spill_fd < 0) {
+    error(0);
+  }
+  unlink(path);
+  free(path);
+}
+
+// Appends hashes of block to the spill file. On failure, calls error with
+// code 0.
+static void write_hashes(Frontier *frontier, Block *block) {
+  if (frontier->spill_fd < 0) {
+    open_spill_file(frontier);
+  }
+
+  size_t bytes = block->used * frontier->hash_bytes;
+  if (pwrite(frontier->spill_fd, block->data, bytes, frontier->spill_bytes) !=
+      (ssize_t)bytes) {
+    error(0);
+  }
+  frontier->spill_bytes += (off_t)bytes;
+}
+
+// Adds run of given number of sorted hashes at offset of the spill file.
+static void add_run(Frontier *frontier, off_t offset, size_t hashes) {
+  if (frontier->runs_number == frontier->runs_capacity) {
+    frontier->runs_capacity = 2 * frontier->runs_capacity + 1;
+    frontier->runs = (Run *)safe_realloc(
+        frontier->runs, frontier->runs_capacity * sizeof(Run));
+  }
+  frontier->runs[frontier->runs_number++] =
+      (Run){.offset = offset, .unread = hashes};
+}
+
+// Reads next hashes of run into its buffer, as many as fit. Returns false
+// if there are none left. On failure, calls error with code 0.
+static bool read_run(Frontier *frontier, Run *run) {
+  if (run->unread == 0) {
+    return false;
+  }
+
+  size_t hashes = run->unread < frontier->hashes_per_block
+                      ? run->unread
+                      : frontier->hashes_per_block;
+  size_t bytes = hashes * frontier->hash_bytes;
+  if (pread(frontier->spill_fd, run->buffer->data, bytes, run->offset) !=
+      (ssize_t)bytes) {
+    error(0);
+  }
+  run->offset += (off_t)bytes;
+  run->unread -= hashes;
+  run->buffer->used = hashes;
+  run->next = 0;
+  run->head = read_hash(frontier, run->buffer->data, 0);
+
+  return true;
+}
+
+// Restores order of a binary min-heap of n runs, whose i-th run may have
+// larger head than its children.
+static void sift_down(Run *heap, size_t n, size_t i) {
+  while (true) {
+    size_t smallest = i;
+    for (size_t child = 2 * i + 1; child <= 2 * i + 2 && child < n; child++) {
+      if (heap[child].head < heap[smallest].head) {
+        smallest = child;
+      }
+    }
+    if (smallest == i) {
+      return;
+    }
+
+    Run run = heap[i];
+    heap[i] = heap[smallest];
+    heap[smallest] = run;
+    i = smallest;
+  }
+}
+
+// Gives each of n runs a block as buffer, reads their first hashes and
+// orders them as a binary min-heap.
+static void start_merge(Frontier *frontier, Run *heap, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    heap[i].buffer = take_block(frontier);
+    read_run(frontier, &heap[i]);
+  }
+  for (size_t i = n / 2; i-- > 0;) {
+    sift_down(heap, n, i);
+  }
+  frontier->last_merged = SIZE_MAX;
+}
+
+// Moves smallest hashes of a heap of *n runs to block, until it's full or
+// the runs run out, and returns their number. Repeated hashes are dropped.
+// Runs that run out are removed from heap, keeping their buffers for later.
+static size_t merge_runs(Frontier *frontier, Run *heap, size_t *n,
+                         Block *block) {
+  block->used = 0;
+  while (*n > 0 && block->used < frontier->hashes_per_block) {
+    Run *run = &heap[0];
+    if (run->head != frontier->last_merged) {
+      write_hash(frontier, block->data, block->used++, run->head);
+      frontier->last_merged = run->head;
+    } else {
+      --frontier->hashes_number;
+    }
+
+    if (++run->next < run->buffer->used) {
+      run->head = read_hash(frontier, run->buffer->data, run->next);
+    } else if (!read_run(frontier, run)) {
+      keep_block(frontier, run->buffer);
+      heap[0] = heap[--*n];
+    }
+    sift_down(heap, *n, 0);
+  }
+
+  return block->used;
+}
+
+// Sorts hashes of a block, so that positions close in memory are expanded
+// together, and appends it to the spill file as a run. On
+// failure, calls error with code 0.
+static void spill_block(Frontier *frontier, Block *block) {
+  qsort(block->data, block->used, frontier->hash_bytes,
+        frontier->hash_bytes == 4 ? compare_hashes32 : compare_hashes64);
+  off_t offset = frontier->spill_bytes;
+  write_hashes(frontier, block);
+  add_run(frontier, offset, block->used);
+}
+
+// Spills the rest of blocks of a frontier that has already spilled some,
+// and merges its runs until each of them can be buffered by a spare block
+// but one, which takes merged hashes. While there are more runs, the
+// oldest ones are merged into a new run at the end of the spill file. On
+// failure, calls error with code 0.
+static void start_unspilling(Frontier *frontier) {
+  while (frontier->blocks != NULL) {
+    Block *block = frontier->blocks;
+    frontier->blocks = block->next;
+    spill_block(frontier, block);
+    keep_block(frontier, block);
+  }
+
+  // memory limit lets frontier take at least MIN_BLOCKS blocks
+  size_t fan_in = frontier->blocks_number > MIN_BLOCKS
+                      ? frontier->blocks_number - 1
+                      : MIN_BLOCKS - 1;
+  while (frontier->runs_number - frontier->first_run > fan_in) {
+    Block *block = take_block(frontier);
+    Run *heap = &frontier->runs[frontier->first_run];
+    size_t n = fan_in;
+    start_merge(frontier, heap, n);
+    frontier->first_run += fan_in;
+
+    off_t offset = frontier->spill_bytes;
+    size_t hashes = 0;
+    while (merge_runs(frontier, heap, &n, block) > 0) {
+      write_hashes(frontier, block);
+      hashes += block->used;
+    }
+    keep_block(frontier, block);
+    add_run(frontier, offset, hashes);
+  }
+
+  frontier->merged_runs = frontier->runs_number - frontier->first_run;
+  start_merge(frontier, &frontier->runs[frontier->first_run],
+              frontier->merged_runs);
+}
+
+// Merges spilled runs into the next block of hashes on top of the stack of
+// blocks. On failure, calls error with code 0.
+static void unspill_block(Frontier *frontier) {
+  Block *block = take_block(frontier);
+  merge_runs(frontier, &frontier->runs[frontier->first_run],
+             &frontier->merged_runs, block);
+  block->next = frontier->blocks;
+  frontier->blocks = block;
+
+  if (frontier->merged_runs == 0) {
+    // spill file is overwritten from its beginning by the next level
+    frontier->runs_number = frontier->first_run = 0;
+    frontier->spill_bytes = 0;
+  }
+}
+
+void frontier_set_memory_limit(size_t bytes) {
+  memory_limit =
+      bytes < MIN_BLOCKS * sizeof(Block) ? MIN_BLOCKS * sizeof(Block) : bytes;
+}
+
+Frontier *frontier_create(size_t size) {
+  Frontier *frontier = (Frontier *)safe_calloc(1, sizeof(Frontier));
+  frontier->size = size;
+  frontier->hash_bytes = size - 1 <= UINT32_MAX ? 4 : 8;
+  frontier->hashes_per_block = BLOCK_BYTES / frontier->hash_bytes;
+  frontier->memory_limit = memory_limit;
+  frontier->spill_fd = -1;
+
+  return frontier;
+}
+
+void frontier_reset(Frontier *frontier, size_t size) {
+  // keep blocks for the next levels
+  while (frontier->blocks != NULL) {
+    Block *block = frontier->blocks;
+    frontier->blocks = block->next;
+    keep_block(frontier, block);
+  }
+  for (size_t i = 0; i < frontier->merged_runs; i++) {
+    keep_block(frontier, frontier->runs[frontier->first_run + i].buffer);
+  }
+
+  if (frontier->bitmap != NULL && frontier->size != size) {
+    bitset_free(frontier->bitmap);
+    frontier->bitmap = NULL;
+  } else if (frontier->dense) {
+    bitset_clear(frontier->bitmap);
+  }
+
+  frontier->size = size;
+  frontier->hash_bytes = size - 1 <= UINT32_MAX ? 4 : 8;
+  frontier->hashes_per_block = BLOCK_BYTES / frontier->hash_bytes;
+  frontier->hashes_number = 0;
+  frontier->dense = false;
+  frontier->first_word = 0;
+  frontier->memory_limit = memory_limit;
+  // spill file is overwritten from its beginning
+  frontier->spill_bytes = 0;
+  frontier->runs_number = frontier->first_run = frontier->merged_runs = 0;
+}
+
+void frontier_free(Frontier *frontier) {
+  if (frontier != NULL) {
+    free_blocks(frontier->blocks);
+    free_blocks(frontier->spare_blocks);
+    for (size_t i = 0; i < frontier->merged_runs; i++) {
+      free(frontier->runs[frontier->first_run + i].buffer);
+    }
+    free(frontier->runs);
+    bitset_free(frontier->bitmap);
+    if (frontier->spill_fd >= 0) {
+      close(frontier->spill_fd);
+    }
+    free(frontier);
+  }
+}
+
+void frontier_push(Frontier *frontier, size_t hash) {
+  ++frontier->hashes_number;
+
+  if (frontier->dense) {
+    bitset_set(frontier->bitmap, hash);
+    if (hash / 64 < frontier->first_word) {
+      frontier->first_word = hash / 64;
+    }
+    return;
+  }
+
+  Block *block = frontier->blocks;
+  if (block != NULL && block->used == frontier->hashes_per_block &&
+      frontier->spare_blocks == NULL &&
+      (frontier->blocks_number + 1) * sizeof(Block) >
+          frontier->memory_limit) {
+    // write the full block to disk and reuse it
+    spill_block(frontier, block);
+    block->used = 0;
+  } else if (block == NULL || block->used == frontier->hashes_per_block) {
+    // take a new block
+    block = take_block(frontier);
+    block->used = 0;
+    block->next = frontier->blocks;
+    frontier->blocks = block;
+  }
+
+  write_hash(frontier, block->data, block->used, hash);
+  ++block->used;
+
+  // bitmap takes size / 8 bytes
+  if (frontier->hashes_number > frontier->size / 8 / frontier->hash_bytes &&
+      frontier->size / 8 <= frontier->memory_limit) {
+    switch_to_bitmap(frontier);
+  }
+}
+
+size_t frontier_pop(Frontier *frontier) {
+  --frontier->hashes_number;
+
+  if (frontier->dense) {
+    uint64_t *words = bitset_data(frontier->bitmap);
+    while (words[frontier->first_word] == 0) {
+      ++frontier->first_word;
+    }
+
+    uint64_t *word = &words[frontier->first_word];
+    size_t hash = frontier->first_word * 64 + (size_t)__builtin_ctzll(*word);
+    *word &= *word - 1;
+
+    if (frontier->hashes_number == 0) {
+      // bitmap is empty again, so the next level starts in blocks
+      frontier->dense = false;
+    }
+
+    return hash;
+  }
+
+  if (frontier->runs_number > 0 && frontier->merged_runs == 0) {
+    start_unspilling(frontier);
+  }
+  if (frontier->blocks == NULL) {
+    unspill_block(frontier);
+  }
+
+  Block *block = frontier->blocks;
+  --block->used;
+  size_t hash = read_hash(frontier, block->data, block->used);
+
+  if (block->used == 0) {
+    // keep empty block for later
+    frontier->blocks = block->next;
+    keep_block(frontier, block);
+  }
+
+  return hash;
+}
+
+size_t frontier_size(Frontier *frontier) {
+  return frontier->hashes_number;
+}
+
+bool frontier_is_empty(Frontier *frontier) {
+  return frontier->hashes_number == 0;
+}
+
+size_t frontier_bytes(Frontier *frontier) {
+  size_t bytes = frontier->blocks_number * sizeof(Block);
+  if (frontier->bitmap != NULL) {
+    bytes += bitset_words_number(frontier->bitmap) * sizeof(uint64_t);
+  }
+
+  return bytes;
+}
@@ -0,0 +1,48 @@
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Set of position hashes of one bfs level. Hashes are stored as 32-bit
+// numbers if they fit, in fixed-size blocks reused between levels, and
+// the whole set is switched to a bitmap once that takes less memory.
+typedef struct Frontier Frontier;
+
+// Limits memory of blocks of every frontier created afterwards to given
+// number of bytes, but no less than three blocks. Full blocks over the
+// limit are sorted and written as runs to an unlinked temporary file in
+// TMPDIR (/tmp by default). Once blocks in memory are popped, the runs
+// are merged, dropping repeated hashes, through blocks within the limit,
+// in more passes if there are more runs than blocks. Bitmap is used only
+// if it fits in the limit. By default, memory isn't limited.
+void frontier_set_memory_limit(size_t bytes);
+
+// Creates empty frontier for hashes smaller than size.
+Frontier *frontier_create(size_t size);
+
+// Empties frontier and makes it hold hashes smaller than size, keeping
+// its blocks, so that it can be used by another search.
+void frontier_reset(Frontier *frontier, size_t size);
+
+// Frees all allocated memory of passed frontier.
+void frontier_free(Frontier *frontier);
+
+// Adds hash to frontier. Assumes that it isn't there yet, and that no hash
+// was popped since frontier was last empty.
+void frontier_push(Frontier *frontier, size_t hash);
+
+// Removes any hash from frontier and returns it. Assumes that frontier
+// isn't empty.
+size_t frontier_pop(Frontier *frontier);
+
+// Returns number of hashes in frontier.
+size_t frontier_size(Frontier *frontier);
+
+// Checks if frontier is empty.
+bool frontier_is_empty(Frontier *frontier);
+
+// Returns number of bytes currently allocated by frontier.
+size_t frontier_bytes(Frontier *frontier);
+
+#endif  // FRONTIER_H
@@ -0,0 +1,112 @@
+#include "grid.h"
+#include "utils.h"
+
+// Grid is created only if it has at most MAX_GROWTH times more positions
+// than maze.
+#define MAX_GROWTH 4
+
+// Returns number of positions of maze with border or SIZE_MAX on overflow.
+static size_t bordered_size(Maze *maze) {
+  size_t size = 1;
+  for (size_t i = 0; i < maze_dimensions_number(maze); i++) {
+    size = safe_product(size, safe_sum(maze_dimension(maze, i), 2));
+  }
+
+  return size;
+}
+
+// Copies maze walls into the interior of grid, one row of the first
+// dimension at a time.
+static void copy_walls(Grid *grid, Maze *maze) {
+  size_t k = grid->dimensions_number;
+  size_t row_length = maze_dimension(maze, 0);
+  size_t rows_number = maze_size(maze) / row_length;
+
+  // coordinates of the current row in dimensions 1..k-1, counted from 0
+  uint64_t *coordinates = (uint64_t *)safe_calloc(k, sizeof(uint64_t));
+
+  // the first row starts after the border in every dimension
+  size_t grid_row = 0;
+  for (size_t i = 0; i < k; i++) {
+    grid_row += grid->strides[i];
+  }
+
+  for (size_t row = 0; row < rows_number; row++) {
+    bitset_copy_bits(grid->walls, grid_row, maze_walls(maze),
+                     row * row_length, row_length);
+
+    // move to the next row
+    for (size_t i = 1; i < k; i++) {
+      if (++coordinates[i] < maze_dimension(maze, i)) {
+        grid_row += grid->strides[i];
+        break;
+      }
+
+      grid_row -= (coordinates[i] - 1) * grid->strides[i];
+      coordinates[i] = 0;
+    }
+  }
+
+  free(coordinates);
+}
+
+Grid *grid_create(Maze *maze) {
+  size_t size = bordered_size(maze);
+  if (size == SIZE_MAX || size / MAX_GROWTH > maze_size(maze) ||
+      bitset_is_periodic(maze_walls(maze))) {
+    return NULL;
+  }
+
+  Grid *grid = (Grid *)safe_malloc(sizeof(Grid));
+  grid->dimensions_number = maze_dimensions_number(maze);
+  grid->dimensions =
+      (uint64_t *)safe_calloc(grid->dimensions_number, sizeof(uint64_t));
+  grid->strides = (size_t *)safe_calloc(grid->dimensions_number,
+                                        sizeof(size_t));
+  grid->size = size;
+
+  size_t N = 1;
+  for (size_t i = 0; i < grid->dimensions_number; i++) {
+    grid->dimensions[i] = maze_dimension(maze, i) + 2;
+    grid->strides[i] = N;
+    N *= grid->dimensions[i];
+  }
+
+  // every position is a wall until maze walls are copied inside
+  grid->walls = maze_visited(maze, size);
+  bitset_fill(grid->walls);
+  copy_walls(grid, maze);
+
+  grid->start_position_hash =
+      grid_position_hash(grid, maze, maze_start_position_hash(maze));
+  grid->end_position_hash =
+      grid_position_hash(grid, maze, maze_end_position_hash(maze));
+
+  return grid;
+}
+
+void grid_free(Grid *grid) {
+  if (grid != NULL) {
+    free(grid->dimensions);
+    free(grid->strides);
+    free(grid);
+  }
+}
+
+size_t grid_position_hash(Grid *grid, Maze *maze, size_t position_hash) {
+  size_t hash = 0;
+  for (size_t i = 0; i < grid->dimensions_number; i++) {
+    uint64_t n_i = maze_dimension(maze, i);
+    hash += (1 + position_hash % n_i) * grid->strides[i];
+    position_hash /= n_i;
+  }
+
+  return hash;
+}
+
+void grid_neighbour_offsets(Grid *grid, ptrdiff_t *offsets) {
+  for (size_t i = 0; i < grid->dimensions_number; i++) {
+    offsets[2 * i] = -(ptrdiff_t)grid->strides[i];
+    offsets[2 * i + 1] = (ptrdiff_t)grid->strides[i];
+  }
+}
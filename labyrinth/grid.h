@@ -0,0 +1,46 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bitset.h"
+#include "maze.h"
+
+// Mazes with at least this many positions are searched without a grid,
+// because building it touches every position, however few of them are
+// visited.
+#define GRID_SIZE_MAX (1ULL << 32)
+
+// Maze surrounded by a border of walls. Every free position of a grid
+// has all its neighbours inside the grid, so moving in i-th dimension
+// always changes position hash by strides[i] and needs no bounds checks.
+typedef struct {
+  size_t dimensions_number;
+  // dimensions of the grid, i.e. maze dimensions increased by 2
+  uint64_t *dimensions;
+  // distance between hashes of neighbours in i-th dimension
+  size_t *strides;
+  // number of positions of the grid
+  size_t size;
+  Bitset *walls;
+  size_t start_position_hash;
+  size_t end_position_hash;
+} Grid;
+
+// Creates grid from maze walls. Maze walls aren't modified, grid walls
+// are kept in the visited bitset of maze (see maze_visited). Returns NULL
+// if the border would make grid much larger than maze or maze walls are
+// periodic.
+Grid *grid_create(Maze *maze);
+
+// Frees all allocated memory of passed grid.
+void grid_free(Grid *grid);
+
+// Returns hash of maze position in the grid.
+size_t grid_position_hash(Grid *grid, Maze *maze, size_t position_hash);
+
+// Fills offsets with 2 * dimensions_number differences between hashes of
+// a position and its neighbours.
+void grid_neighbour_offsets(Grid *grid, ptrdiff_t *offsets);
+
+#endif  // GRID_H
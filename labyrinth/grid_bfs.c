@@ -0,0 +1,123 @@
+#include "grid_bfs.h"
+#include "bitset.h"
+#include "frontier.h"
+#include "stats.h"
+#include "utils.h"
+
+// Grids with at most this many dimensions are searched by kernels.
+#define KERNEL_DIMENSIONS_MAX 4
+
+// Records bfs level, which expanded given number of positions and checked
+// given number of their neighbours, in statistics.
+static void record_level(size_t expanded, size_t neighbour_checks,
+                         Frontier *current, Frontier *next) {
+  stats_level(expanded, neighbour_checks,
+              frontier_bytes(current) + frontier_bytes(next));
+}
+
+// Searches grid with k dimensions. Neighbours are found by adding
+// offsets to position hash, because the grid border makes bounds checks
+// unnecessary. It's inlined into kernels with constant k, so that the
+// loop over neighbours is unrolled and offsets are kept in registers.
+static inline __attribute__((always_inline)) size_t
+find_shortest_path(Maze *maze, Grid *grid, size_t k) {
+  size_t answer = 0, depth = 0;
+  ptrdiff_t kernel_offsets[2 * KERNEL_DIMENSIONS_MAX];
+  ptrdiff_t *offsets =
+      k <= KERNEL_DIMENSIONS_MAX
+          ? kernel_offsets
+          : (ptrdiff_t *)safe_calloc(2 * k, sizeof(ptrdiff_t));
+  grid_neighbour_offsets(grid, offsets);
+
+  // will store hashes of positions
+  Frontier *current_depth_positions, *next_depth_positions;
+  maze_frontiers(maze, grid->size, &current_depth_positions,
+                 &next_depth_positions);
+
+  // initialize bfs using start position
+  frontier_push(current_depth_positions, grid->start_position_hash);
+  bitset_set(grid->walls, grid->start_position_hash);
+
+  size_t expanded = 0, neighbour_checks = 0;
+  while (!answer && !frontier_is_empty(current_depth_positions)) {
+    uint64_t position_hash = frontier_pop(current_depth_positions);
+    ++expanded;
+
+#pragma GCC unroll 8
+    for (size_t j = 0; j < 2 * k; j++) {
+      size_t next_position_hash = position_hash + offsets[j];
+      ++neighbour_checks;
+      if (bitset_get(grid->walls, next_position_hash)) {
+        continue;
+      }
+
+      if (next_position_hash == grid->end_position_hash) {
+        answer = depth + 1;
+        break;
+      }
+
+      frontier_push(next_depth_positions, next_position_hash);
+      bitset_set(grid->walls, next_position_hash);
+    }
+
+    // check if all positions of current depth were visited
+    if (frontier_is_empty(current_depth_positions)) {
+      record_level(expanded, neighbour_checks, current_depth_positions,
+                   next_depth_positions);
+      expanded = neighbour_checks = 0;
+      ++depth;
+      swap((void **)&current_depth_positions, (void **)&next_depth_positions);
+    }
+  }
+
+  if (expanded > 0) {
+    record_level(expanded, neighbour_checks, current_depth_positions,
+                 next_depth_positions);
+  }
+
+  if (offsets != kernel_offsets) {
+    free(offsets);
+  }
+
+  return answer;
+}
+
+// Defines kernel searching grids with K dimensions.
+#define DEFINE_KERNEL(K)                                         \
+  static size_t find_shortest_path_##K(Maze *maze, Grid *grid) { \
+    return find_shortest_path(maze, grid, K);                    \
+  }
+
+DEFINE_KERNEL(1)
+DEFINE_KERNEL(2)
+DEFINE_KERNEL(3)
+DEFINE_KERNEL(4)
+
+// Kernels indexed by number of dimensions.
+static size_t (*const kernels[KERNEL_DIMENSIONS_MAX + 1])(Maze *, Grid *) = {
+    NULL,
+    find_shortest_path_1,
+    find_shortest_path_2,
+    find_shortest_path_3,
+    find_shortest_path_4,
+};
+
+size_t grid_bfs_find_shortest_path(Maze *maze, Grid *grid) {
+  if (grid->dimensions_number <= KERNEL_DIMENSIONS_MAX) {
+    return kernels[grid->dimensions_number](maze, grid);
+  }
+
+  return find_shortest_path(maze, grid, grid->dimensions_number);
+}
+
+size_t line_find_shortest_path(Maze *maze) {
+  size_t start = maze_start_position_hash(maze);
+  size_t end = maze_end_position_hash(maze);
+  if (start > end) {
+    size_t temp = start;
+    start = end;
+    end = temp;
+  }
+
+  return bitset_any(maze_walls(maze), start, end + 1) ? 0 : end - start;
+}
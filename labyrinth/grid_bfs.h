@@ -0,0 +1,22 @@
+#ifndef GRID_BFS_H
+#define GRID_BFS_H
+
+#include <stddef.h>
+#include "grid.h"
+#include "maze.h"
+
+// Finds length of the shortest path from start to end position of grid
+// created from maze using bfs and returns it. If it doesn't exist,
+// returns 0. Marks visited positions as grid walls and keeps frontiers
+// in maze storage. Grids with up to 4 dimensions are searched by kernels
+// compiled for their number of dimensions, with neighbour offsets
+// unrolled. Assumes that start and end positions are not equal.
+size_t grid_bfs_find_shortest_path(Maze *maze, Grid *grid);
+
+// Finds length of the shortest path from start to end position of
+// one-dimensional maze and returns it. If it doesn't exist, returns 0.
+// Needs no search: the path exists if there are no walls between both
+// positions. Assumes that maze has one dimension.
+size_t line_find_shortest_path(Maze *maze);
+
+#endif  // GRID_BFS_H
@@ -0,0 +1,211 @@
+#include "hybrid_bfs.h"
+#include <stdbool.h>
+#include "bitset.h"
+#include "utils.h"
+#include "vector.h"
+
+// Search switches to bottom-up steps when the frontier is larger than
+// 1 / ALPHA of unexplored positions and back to top-down steps when it's
+// smaller than 1 / BETA of the maze.
+#define ALPHA 14
+#define BETA 24
+
+// State of a search.
+typedef struct {
+  Maze *maze;
+  Bitset *walls;
+  Bitset *visited;
+  size_t size;
+  size_t dimensions_number;
+  size_t end_position_hash;
+
+  // current level as a list (in top-down steps) or a bitmap (in bottom-up
+  // steps) and place for the next one
+  bool bottom_up;
+  Vector *current_depth_positions;
+  Vector *next_depth_positions;
+  Bitset *current_depth_bitmap;
+  Bitset *next_depth_bitmap;
+  size_t current_level_size;
+  size_t next_level_size;
+} Search;
+
+// Visits position in a top-down step. Returns true if it's end position.
+static bool visit_position(Search *search, size_t position_hash) {
+  if (bitset_get(search->walls, position_hash) ||
+      bitset_get(search->visited, position_hash)) {
+    return false;
+  }
+  if (position_hash == search->end_position_hash) {
+    return true;
+  }
+
+  bitset_set(search->visited, position_hash);
+  vector_push_back(search->next_depth_positions, position_hash);
+  ++search->next_level_size;
+
+  return false;
+}
+
+// Expands current level from the list of its positions. Returns true
+// if end position was reached.
+static bool top_down_step(Search *search) {
+  vector_clear(search->next_depth_positions);
+
+  while (!vector_is_empty(search->current_depth_positions)) {
+    size_t position_hash = vector_pop_back(search->current_depth_positions);
+    size_t rest = position_hash, N = 1;
+
+    for (size_t i = 0; i < search->dimensions_number; i++) {
+      uint64_t n_i = maze_dimension(search->maze, i);
+      uint64_t z_i = rest % n_i;
+      rest /= n_i;
+
+      // decrement and increment i-th coordinate
+      if ((z_i > 0 && visit_position(search, position_hash - N)) ||
+          (z_i + 1 < n_i && visit_position(search, position_hash + N))) {
+        return true;
+      }
+
+      N *= n_i;
+    }
+  }
+
+  swap((void **)&search->current_depth_positions,
+       (void **)&search->next_depth_positions);
+
+  return false;
+}
+
+// Checks if any position adjacent to given one belongs to current level.
+static bool has_parent(Search *search, size_t position_hash) {
+  size_t rest = position_hash, N = 1;
+
+  for (size_t i = 0; i < search->dimensions_number; i++) {
+    uint64_t n_i = maze_dimension(search->maze, i);
+    uint64_t z_i = rest % n_i;
+    rest /= n_i;
+
+    if ((z_i > 0 &&
+         bitset_get(search->current_depth_bitmap, position_hash - N)) ||
+        (z_i + 1 < n_i &&
+         bitset_get(search->current_depth_bitmap, position_hash + N))) {
+      return true;
+    }
+
+    N *= n_i;
+  }
+
+  return false;
+}
+
+// Finds next level by checking every unvisited free position. Returns true
+// if end position was reached.
+static bool bottom_up_step(Search *search) {
+  uint64_t *walls = bitset_data(search->walls);
+  uint64_t *visited = bitset_data(search->visited);
+  size_t words_number = bitset_words_number(search->walls);
+  bitset_clear(search->next_depth_bitmap);
+
+  for (size_t w = 0; w < words_number; w++) {
+    uint64_t unvisited = ~(walls[w] | visited[w]);
+    if (w == words_number - 1) {
+      // ignore bits past the end of maze
+      unvisited &= (1ULL << (search->size % 64)) - 1;
+    }
+
+    while (unvisited != 0) {
+      size_t position_hash = w * 64 + (size_t)__builtin_ctzll(unvisited);
+      unvisited &= unvisited - 1;
+
+      if (has_parent(search, position_hash)) {
+        if (position_hash == search->end_position_hash) {
+          return true;
+        }
+
+        visited[w] |= 1ULL << (position_hash % 64);
+        bitset_set(search->next_depth_bitmap, position_hash);
+        ++search->next_level_size;
+      }
+    }
+  }
+
+  swap((void **)&search->current_depth_bitmap,
+       (void **)&search->next_depth_bitmap);
+
+  return false;
+}
+
+// Moves current level from the list to the bitmap.
+static void list_to_bitmap(Search *search) {
+  bitset_clear(search->current_depth_bitmap);
+  while (!vector_is_empty(search->current_depth_positions)) {
+    bitset_set(search->current_depth_bitmap,
+               vector_pop_back(search->current_depth_positions));
+  }
+}
+
+// Moves current level from the bitmap to the list.
+static void bitmap_to_list(Search *search) {
+  uint64_t *bitmap = bitset_data(search->current_depth_bitmap);
+  for (size_t w = 0; w < bitset_words_number(search->current_depth_bitmap);
+       w++) {
+    for (uint64_t bits = bitmap[w]; bits != 0; bits &= bits - 1) {
+      vector_push_back(search->current_depth_positions,
+                       w * 64 + (size_t)__builtin_ctzll(bits));
+    }
+  }
+}
+
+size_t hybrid_find_shortest_path(Maze *maze) {
+  Search search = {0};
+  search.maze = maze;
+  search.walls = maze_walls(maze);
+  search.size = maze_size(maze);
+  search.visited = maze_visited(maze, search.size);
+  search.dimensions_number = maze_dimensions_number(maze);
+  search.end_position_hash = maze_end_position_hash(maze);
+  search.current_depth_positions = vector_create();
+  search.next_depth_positions = vector_create();
+  search.current_depth_bitmap = bitset_create(search.size);
+  search.next_depth_bitmap = bitset_create(search.size);
+
+  // initialize bfs using start position
+  vector_push_back(search.current_depth_positions,
+                   maze_start_position_hash(maze));
+  bitset_set(search.visited, maze_start_position_hash(maze));
+  search.current_level_size = 1;
+  size_t unexplored = search.size - bitset_count(search.walls) - 1;
+
+  size_t answer = 0, depth = 0;
+  while (!answer && search.current_level_size > 0) {
+    // choose direction of the step
+    if (!search.bottom_up &&
+        safe_product(search.current_level_size, ALPHA) > unexplored) {
+      list_to_bitmap(&search);
+      search.bottom_up = true;
+    } else if (search.bottom_up &&
+               safe_product(search.current_level_size, BETA) < search.size) {
+      bitmap_to_list(&search);
+      search.bottom_up = false;
+    }
+
+    search.next_level_size = 0;
+    bool end_reached = search.bottom_up ? bottom_up_step(&search)
+                                        : top_down_step(&search);
+    if (end_reached) {
+      answer = depth + 1;
+    }
+
+    unexplored -= search.next_level_size;
+    search.current_level_size = search.next_level_size;
+    ++depth;
+  }
+
+  vector_free(search.current_depth_positions);
+  vector_free(search.next_depth_positions);
+  bitset_free(search.current_depth_bitmap);
+  bitset_free(search.next_depth_bitmap);
+
+  return answer;
+}
@@ -0,0 +1,15 @@
+#ifndef HYBRID_BFS_H
+#define HYBRID_BFS_H
+
+#include <stddef.h>
+#include "maze.h"
+
+// Finds length of the shortest path from start to end position using
+// direction-optimizing bfs. Narrow levels are expanded top-down from a
+// list of positions, wide levels bottom-up by scanning unvisited free
+// positions for a neighbour in the frontier bitmap. Returns 0 if the path
+// doesn't exist. Keeps visited positions apart from walls in the visited
+// bitset of maze. Assumes that start and end positions are not equal.
+size_t hybrid_find_shortest_path(Maze *maze);
+
+#endif  // HYBRID_BFS_H
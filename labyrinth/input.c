@@ -1,94 +1,336 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "input.h"
 #include <ctype.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <unistd.h>
 #include "bitset.h"
+#include "stats.h"
 #include "utils.h"
 #include "vector.h"
 
-// Reads standard input until EOF or \n occurs and saves it to passed array.
-// Leading and trailing whitespaces are skipped and array ends with \0.
-// If the first character is EOF, returns false. Otherwise, returns true.
-static bool read_line(char **line, size_t *line_size) {
-  size_t line_length = 0;
-  (*line)[0] = '\0';
+// Size of blocks in which standard input is read.
+#define BLOCK_SIZE (1 << 22)
+
+// Number of blocks, so that one can be read while another is processed.
+#define BLOCKS_NUMBER 2
+
+// Input read in large blocks. Standard input is read by a separate
+// thread, blocks are filled and consumed in a cycle. A string is a single
+// block that isn't copied.
+typedef struct {
+  char *blocks[BLOCKS_NUMBER];
+  size_t lengths[BLOCKS_NUMBER];
+  // numbers of blocks filled by the reading thread and released by reader
+  size_t filled;
+  size_t released;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  bool started;
+  bool from_string;
+
+  // block being processed and position of the next character in it
+  const char *block;
+  size_t length;
+  size_t position;
+  bool end_of_file;
+
+  // buffer for lines, kept between mazes
+  char *line;
+  size_t line_size;
+} Reader;
+
+static Reader stdin_reader = {.mutex = PTHREAD_MUTEX_INITIALIZER,
+                              .cond = PTHREAD_COND_INITIALIZER};
+
+// Reads standard input to free blocks of reader until EOF or read error.
+static void *read_blocks(void *reader_ptr) {
+  Reader *reader = (Reader *)reader_ptr;
+
+  bool end_of_file = false;
+  while (!end_of_file) {
+    pthread_mutex_lock(&reader->mutex);
+    while (reader->filled - reader->released == BLOCKS_NUMBER) {
+      pthread_cond_wait(&reader->cond, &reader->mutex);
+    }
+    size_t i = reader->filled % BLOCKS_NUMBER;
+    pthread_mutex_unlock(&reader->mutex);
+
+    ssize_t length = read(STDIN_FILENO, reader->blocks[i], BLOCK_SIZE);
+    end_of_file = length <= 0;
 
-  int c = getchar();
-  if (c == EOF) {
+    pthread_mutex_lock(&reader->mutex);
+    reader->lengths[i] = end_of_file ? 0 : (size_t)length;
+    ++reader->filled;
+    pthread_cond_broadcast(&reader->cond);
+    pthread_mutex_unlock(&reader->mutex);
+  }
+
+  return NULL;
+}
+
+// Moves to the next block of input. Returns false on EOF. The reading
+// thread is started with the first call and it's never stopped, because
+// it may wait for input that nobody is going to process.
+static bool next_block(Reader *reader) {
+  if (reader->end_of_file) {
+    return false;
+  } else if (reader->from_string) {
+    // the whole string is the first block
+    reader->end_of_file = true;
     return false;
   }
 
-  // skip leading whitespaces
-  while (isspace(c) && c != '\n') {
-    c = getchar();
+  pthread_mutex_lock(&reader->mutex);
+  if (!reader->started) {
+    for (size_t i = 0; i < BLOCKS_NUMBER; i++) {
+      reader->blocks[i] = (char *)safe_malloc(BLOCK_SIZE);
+    }
+    posix_fadvise(STDIN_FILENO, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, read_blocks, reader) != 0) {
+      error(0);
+    }
+    pthread_detach(thread);
+    reader->started = true;
+  } else {
+    ++reader->released;
+    pthread_cond_broadcast(&reader->cond);
+  }
+
+  while (reader->filled == reader->released) {
+    pthread_cond_wait(&reader->cond, &reader->mutex);
+  }
+  size_t i = reader->released % BLOCKS_NUMBER;
+  reader->block = reader->blocks[i];
+  reader->length = reader->lengths[i];
+  reader->position = 0;
+  pthread_mutex_unlock(&reader->mutex);
+
+  reader->end_of_file = reader->length == 0;
+
+  return !reader->end_of_file;
+}
+
+// Returns the next character of input without consuming it or EOF.
+static int peek_char(Reader *reader) {
+  if (reader->position == reader->length && !next_block(reader)) {
+    return EOF;
+  }
+
+  return (unsigned char)reader->block[reader->position];
+}
+
+// Consumes and returns the next character of input or EOF.
+static int read_char(Reader *reader) {
+  int c = peek_char(reader);
+  if (c != EOF) {
+    ++reader->position;
+  }
+
+  return c;
+}
+
+// Skips whitespaces other than \n.
+static void skip_spaces(Reader *reader) {
+  int c = peek_char(reader);
+  while (c != EOF && c != '\n' && isspace(c)) {
+    ++reader->position;
+    c = peek_char(reader);
+  }
+}
+
+// Skips input until EOF or \n occurs.
+static void skip_line(Reader *reader) {
+  int c = read_char(reader);
+  while (c != '\n' && c != EOF) {
+    c = read_char(reader);
+  }
+}
+
+// Reads input until EOF or \n occurs and saves it to the line buffer of
+// reader. Leading and trailing whitespaces are skipped and line ends with
+// \0. If the first character is EOF, returns false. Otherwise, returns
+// true.
+static bool read_line(Reader *reader) {
+  size_t line_length = 0;
+  if (reader->line == NULL) {
+    reader->line_size = 1;
+    reader->line = (char *)safe_malloc(sizeof(char));
+  }
+  reader->line[0] = '\0';
+
+  if (peek_char(reader) == EOF) {
+    return false;
   }
 
+  skip_spaces(reader);
+
+  int c = read_char(reader);
   while (c != '\n' && c != EOF) {
-    (*line)[line_length++] = (char)c;
-    c = getchar();
+    reader->line[line_length++] = (char)c;
+    c = read_char(reader);
 
-    if (*line_size == line_length) {
-      *line_size *= 2;
-      *line = (char *)safe_realloc(*line, *line_size * sizeof(char));
+    if (reader->line_size == line_length) {
+      reader->line_size *= 2;
+      reader->line = (char *)safe_realloc(reader->line,
+                                          reader->line_size * sizeof(char));
     }
   }
 
   // skip trailing whitespaces
-  while (line_length > 0 && isspace((*line)[line_length - 1])) {
+  while (line_length > 0 && isspace(reader->line[line_length - 1])) {
     line_length--;
   }
 
-  (*line)[line_length] = '\0';
+  reader->line[line_length] = '\0';
 
   return true;
 }
 
+// Reads rest of a line with hexadecimal walls and decodes it while it's
+// read, so the line is never stored as a whole. Returns NULL if it's
+// incorrect. The whole line is consumed either way.
+static Bitset *read_hexadecimal_walls(Reader *reader, Maze *maze) {
+  HexStream *stream =
+      bitset_hex_stream_create(maze_size(maze), maze_take_spare_walls(maze));
+
+  bool digits_end = false;
+  while (!digits_end && peek_char(reader) != EOF) {
+    size_t available = reader->length - reader->position;
+    size_t decoded = bitset_hex_stream_feed(
+        stream, &reader->block[reader->position], available);
+    reader->position += decoded;
+    digits_end = decoded < available;
+  }
+
+  Bitset *walls = bitset_hex_stream_finish(stream);
+
+  if (peek_char(reader) == '\0') {
+    // \0 ends the line just like in strings read by read_line
+    skip_line(reader);
+    return walls;
+  }
+
+  // only whitespaces may follow the digits
+  skip_spaces(reader);
+  int c = read_char(reader);
+  if (c != '\n' && c != EOF) {
+    skip_line(reader);
+    bitset_free(walls);
+    return NULL;
+  }
+
+  return walls;
+}
+
+// Reads line with walls. Hexadecimal walls are decoded while they're
+// read and generators are read as a whole line first. Memory of walls of
+// the previous maze is reused for them.
+static Bitset *read_walls(Reader *reader, Maze *maze) {
+  skip_spaces(reader);
+  if (peek_char(reader) == '0') {
+    read_char(reader);
+    int c = read_char(reader);
+    if (c == 'x') {
+      return read_hexadecimal_walls(reader, maze);
+    }
+
+    // incorrect hexadecimal number
+    if (c != '\n' && c != EOF) {
+      skip_line(reader);
+    }
+    return NULL;
+  }
+
+  read_line(reader);
+
+  return bitset_create_from_string(reader->line, maze_size(maze),
+                                   maze_take_spare_walls(maze));
+}
+
 // Processes 4 lines of input. If it's incorrect, returns first
-// incorrect line number. Otherwise, returns 0.
-static int process_input(Maze *maze, char **line, size_t *line_size) {
-  read_line(line, line_size);
-  if (!maze_set_dimensions(maze, vector_create_from_string(*line))) {
-    return 1;
+// incorrect line number. Otherwise, returns 0. If consume_all is set,
+// all 4 lines are consumed either way, so that the next maze can be read.
+static int process_input(Reader *reader, Maze *maze, bool consume_all) {
+  // err is number of the first incorrect line or 0 if they are correct
+  int err = 0;
+
+  read_line(reader);
+  if (!maze_set_dimensions(maze, vector_create_from_string(reader->line))) {
+    err = 1;
   }
 
-  read_line(line, line_size);
-  if (!maze_set_start_position(maze, vector_create_from_string(*line))) {
-    return 2;
+  if (!err || consume_all) {
+    read_line(reader);
+  }
+  if (!err &&
+      !maze_set_start_position(maze, vector_create_from_string(reader->line))) {
+    err = 2;
   }
 
-  read_line(line, line_size);
-  if (!maze_set_end_position(maze, vector_create_from_string(*line))) {
-    return 3;
+  if (!err || consume_all) {
+    read_line(reader);
+  }
+  if (!err &&
+      !maze_set_end_position(maze, vector_create_from_string(reader->line))) {
+    err = 3;
   }
 
-  read_line(line, line_size);
-  if (!maze_set_walls(maze,
-                      bitset_create_from_string(*line, maze_size(maze)))) {
+  if (err) {
+    if (consume_all) {
+      skip_line(reader);
+    }
+    return err;
+  }
+
+  stats_stop(PHASE_PARSE);
+  stats_start(PHASE_WALLS);
+  Bitset *walls = read_walls(reader, maze);
+  bool correct = maze_set_walls(maze, walls);
+  if (correct) {
+    maze_compress_walls(maze);
+  }
+  stats_stop(PHASE_WALLS);
+  stats_start(PHASE_PARSE);
+
+  if (!correct) {
     return 4;
   }
 
+  if (!maze_is_start_position_free(maze)) {
+    return 2;
+  } else if (!maze_is_end_position_free(maze)) {
+    return 3;
+  }
+
   return 0;
 }
 
-bool read_maze_data(Maze *maze) {
-  size_t line_size = 1;
-  char *line = (char *)safe_malloc(sizeof(char));
+// Reads a maze from reader. If only is set, the maze must be followed by
+// the end of input. Returns 0 if it's correct and number of the first
+// incorrect line otherwise.
+static int read_maze(Reader *reader, Maze *maze, bool only) {
+  stats_start(PHASE_PARSE);
+  int err = process_input(reader, maze, !only);
 
-  // err is number of the first incorrect line or 0 if they are correct
-  int err = process_input(maze, &line, &line_size);
-
-  if (!err) {
-    if (!maze_is_start_position_free(maze)) {
-      err = 2;
-    } else if (!maze_is_end_position_free(maze)) {
-      err = 3;
-    } else if (read_line(&line, &line_size)) {
-      // correct input is only 4 lines long
-      err = 5;
-    }
+  if (!err && only && read_line(reader)) {
+    // correct input is only 4 lines long
+    err = 5;
   }
 
-  free(line);
+  stats_stop(PHASE_PARSE);
+
+  return err;
+}
+
+bool read_maze_data(Maze *maze) {
+  int err = read_maze(&stdin_reader, maze, true);
 
   if (err) {
     print_error(err);
@@ -96,3 +338,143 @@ bool read_maze_data(Maze *maze) {
 
   return !err;
 }
+
+int read_next_maze(Maze *maze) {
+  // skip empty lines between mazes
+  skip_spaces(&stdin_reader);
+  while (peek_char(&stdin_reader) == '\n') {
+    read_char(&stdin_reader);
+    skip_spaces(&stdin_reader);
+  }
+
+  if (peek_char(&stdin_reader) == EOF) {
+    return INPUT_END;
+  }
+
+  return read_maze(&stdin_reader, maze, false);
+}
+
+int read_maze_from_string(Maze *maze, const char *text, size_t length) {
+  Reader reader = {.from_string = true, .block = text, .length = length};
+  int err = read_maze(&reader, maze, true);
+  free(reader.line);
+
+  return err;
+}
+
+// Reads a query from line and saves hashes of its positions to queries.
+// Returns false if it's incorrect.
+static bool process_query(Maze *maze, char *line, Vector *queries) {
+  size_t k = maze_dimensions_number(maze);
+  Vector *numbers = vector_create_from_string(line);
+  if (numbers == NULL || vector_size(numbers) != 2 * k) {
+    vector_free(numbers);
+    return false;
+  }
+
+  Vector *position = vector_create();
+  bool correct = true;
+  for (size_t j = 0; j < 2 && correct; j++) {
+    vector_clear(position);
+    for (size_t i = 0; i < k; i++) {
+      vector_push_back(position, vector_get(numbers, j * k + i));
+    }
+
+    size_t hash = 0;
+    correct = maze_free_position_hash(maze, position, &hash);
+    vector_push_back(queries, hash);
+  }
+
+  vector_free(position);
+  vector_free(numbers);
+
+  return correct;
+}
+
+// Processes every non-empty line of file with given path, without
+// leading and trailing whitespaces, with process. If file can't be read
+// or process returns false for any line, prints error with given code
+// and returns false. Otherwise, returns true.
+static bool process_file(Maze *maze, char *path, Vector *result,
+                         bool (*process)(Maze *, char *, Vector *),
+                         int error_code) {
+  FILE *file = fopen(path, "r");
+  if (file == NULL) {
+    print_error(error_code);
+    return false;
+  }
+
+  char *line = NULL;
+  size_t line_size = 0;
+  bool correct = true;
+  ssize_t line_length;
+  while (correct && (line_length = getline(&line, &line_size, file)) != -1) {
+    // skip trailing whitespaces, so that empty lines can be ignored
+    while (line_length > 0 && isspace(line[line_length - 1])) {
+      line_length--;
+    }
+    line[line_length] = '\0';
+
+    char *start = line;
+    while (isspace(*start)) {
+      ++start;
+    }
+
+    if (*start != '\0') {
+      correct = process(maze, start, result);
+    }
+  }
+
+  if (ferror(file)) {
+    correct = false;
+  }
+
+  free(line);
+  fclose(file);
+
+  if (!correct) {
+    print_error(error_code);
+  }
+
+  return correct;
+}
+
+bool read_queries(Maze *maze, char *path, Vector *queries) {
+  return process_file(maze, path, queries, process_query, 6);
+}
+
+// Reads positions of a group of wall edits from line and saves their
+// hashes to edits, followed by EDITS_GROUP_END. Returns false if it's
+// incorrect.
+static bool process_wall_edits(Maze *maze, char *line, Vector *edits) {
+  size_t k = maze_dimensions_number(maze);
+  Vector *numbers = vector_create_from_string(line);
+  if (numbers == NULL || vector_size(numbers) % k != 0) {
+    vector_free(numbers);
+    return false;
+  }
+
+  Vector *position = vector_create();
+  bool correct = true;
+  for (size_t j = 0; j < vector_size(numbers) / k && correct; j++) {
+    vector_clear(position);
+    for (size_t i = 0; i < k; i++) {
+      vector_push_back(position, vector_get(numbers, j * k + i));
+    }
+
+    size_t hash = 0;
+    correct = maze_position_hash(maze, position, &hash) &&
+              hash != maze_start_position_hash(maze);
+    vector_push_back(edits, hash);
+  }
+  vector_push_back(edits, EDITS_GROUP_END);
+
+  vector_free(position);
+  vector_free(numbers);
+
+  return correct;
+}
+
+bool read_wall_edits(Maze *maze, char *path, Vector *edits) {
+  return process_file(maze, path, edits, process_wall_edits, 9);
+}
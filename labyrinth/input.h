@@ -2,9 +2,45 @@
 #define INPUT_H
 
 #include "maze.h"
+#include "vector.h"
+
+// Returned by read_next_maze when there are no more mazes.
+#define INPUT_END (-1)
 
 // Reads standard input and saves it to passed maze. If input is incorrect,
 // prints error and returns false. Otherwise, returns true.
 bool read_maze_data(Maze *maze);
 
+// Reads the next of mazes which follow one another on standard input and
+// saves it to passed maze. Empty lines between mazes are skipped. Returns
+// 0 if it's correct, number of its first incorrect line if it isn't, or
+// INPUT_END if there are no more mazes. Doesn't print errors. All 4
+// lines of an incorrect maze are consumed too, so reading can continue.
+int read_next_maze(Maze *maze);
+
+// Reads the only maze from text of given length, which doesn't have to
+// end with \0, and saves it to passed maze. Returns 0 if it's correct and
+// number of its first incorrect line otherwise, like read_maze_data.
+// Doesn't print errors.
+int read_maze_from_string(Maze *maze, const char *text, size_t length);
+
+// Reads queries about shortest paths in maze from file with given path.
+// Every non-empty line holds coordinates of start position followed by
+// coordinates of end position. Saves hashes of both positions of every
+// query to queries. If file can't be read or any query is incorrect,
+// prints error and returns false. Otherwise, returns true.
+bool read_queries(Maze *maze, char *path, Vector *queries);
+
+// Marks the end of a group of wall edits.
+#define EDITS_GROUP_END SIZE_MAX
+
+// Reads edits of maze walls from file with given path. Every non-empty
+// line holds coordinates of one or more positions, whose walls are
+// toggled together. Saves hashes of positions of every line to edits,
+// followed by EDITS_GROUP_END. If file can't be read or any line is
+// incorrect (wrong number of coordinates or a position outside the maze
+// or equal to start position), prints error and returns false.
+// Otherwise, returns true.
+bool read_wall_edits(Maze *maze, char *path, Vector *edits);
+
 #endif  // INPUT_H
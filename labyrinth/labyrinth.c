@@ -0,0 +1,63 @@
+#include "labyrinth.h"
+#include "input.h"
+#include "mazefile.h"
+#include "parallel.h"
+#include "utils.h"
+
+struct Labyrinth {
+  // reused for every maze, so that walls and storage of searches are
+  // cleared instead of being allocated again
+  Maze *maze;
+};
+
+Labyrinth *labyrinth_create() {
+  Labyrinth *labyrinth = (Labyrinth *)safe_calloc(1, sizeof(Labyrinth));
+  labyrinth->maze = maze_create();
+
+  return labyrinth;
+}
+
+void labyrinth_free(Labyrinth *labyrinth) {
+  if (labyrinth != NULL) {
+    maze_free(labyrinth->maze);
+    free(labyrinth);
+  }
+}
+
+void labyrinth_set_solver(Labyrinth *labyrinth, Solver solver) {
+  maze_set_solver(labyrinth->maze, solver);
+}
+
+void labyrinth_set_layout(Labyrinth *labyrinth, Layout layout) {
+  maze_set_layout(labyrinth->maze, layout);
+}
+
+void labyrinth_set_threads(size_t threads) {
+  parallel_set_threads(threads);
+}
+
+int labyrinth_read(Labyrinth *labyrinth) {
+  maze_clear(labyrinth->maze);
+
+  return read_next_maze(labyrinth->maze);
+}
+
+int labyrinth_load(Labyrinth *labyrinth, const char *text, size_t length) {
+  maze_clear(labyrinth->maze);
+
+  return read_maze_from_string(labyrinth->maze, text, length);
+}
+
+bool labyrinth_open(Labyrinth *labyrinth, const char *path) {
+  maze_clear(labyrinth->maze);
+
+  return mazefile_read(labyrinth->maze, path);
+}
+
+size_t labyrinth_solve(Labyrinth *labyrinth) {
+  return maze_shortest_path_length(labyrinth->maze);
+}
+
+Maze *labyrinth_maze(Labyrinth *labyrinth) {
+  return labyrinth->maze;
+}
@@ -0,0 +1,63 @@
+#ifndef LABYRINTH_H
+#define LABYRINTH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "maze.h"
+
+// Interface of liblabyrinth.a. A context keeps its settings and buffers
+// between mazes, which are loaded and solved one after another: memory of
+// walls, visited positions and frontiers of a maze is cleared and reused
+// for the next one if it's large enough. Number of threads is shared by
+// all contexts. Allocation failures end the process with ERROR 0, as in
+// the program.
+typedef struct Labyrinth Labyrinth;
+
+// Returned by labyrinth_read when there are no more mazes.
+#define LABYRINTH_END (-1)
+
+// Value of labyrinth_solve if the path doesn't exist.
+#define LABYRINTH_NO_WAY MAZE_NO_WAY
+
+// Creates context with default settings: single-threaded row-major bfs.
+Labyrinth *labyrinth_create();
+
+// Frees all allocated memory of passed context.
+void labyrinth_free(Labyrinth *labyrinth);
+
+// Sets algorithm used by labyrinth_solve.
+void labyrinth_set_solver(Labyrinth *labyrinth, Solver solver);
+
+// Sets order of positions used by single-threaded bfs solver.
+void labyrinth_set_layout(Labyrinth *labyrinth, Layout layout);
+
+// Sets number of threads of all contexts. If threads is 0, number of
+// online processors is used.
+void labyrinth_set_threads(size_t threads);
+
+// Replaces the maze of context with the next of mazes that follow one
+// another on standard input. Returns 0 if it's correct, number of its
+// first incorrect line (as in ERROR messages of the program) if it isn't,
+// or LABYRINTH_END if there are no more mazes.
+int labyrinth_read(Labyrinth *labyrinth);
+
+// Replaces the maze of context with the maze given as text of given
+// length, in the format of the program's input. Returns 0 if it's
+// correct and number of its first incorrect line otherwise.
+int labyrinth_load(Labyrinth *labyrinth, const char *text, size_t length);
+
+// Replaces the maze of context with the maze from binary file with given
+// path, written by the program with -B. Returns false if it can't be read
+// or it's incorrect.
+bool labyrinth_open(Labyrinth *labyrinth, const char *path);
+
+// Returns length of the shortest path from start to end position of the
+// maze of context or LABYRINTH_NO_WAY if it doesn't exist. Every call
+// searches the maze again, as searches leave its walls intact. Assumes
+// that the last loaded maze was correct.
+size_t labyrinth_solve(Labyrinth *labyrinth);
+
+// Returns maze of context.
+Maze *labyrinth_maze(Labyrinth *labyrinth);
+
+#endif  // LABYRINTH_H
@@ -1,14 +1,387 @@
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+#include "components.h"
+#include "distances.h"
+#include "dynamic.h"
+#include "frontier.h"
 #include "input.h"
 #include "maze.h"
+#include "mazefile.h"
+#include "parallel.h"
+#include "stats.h"
+#include "utils.h"
 
-int main() {
+// Program options which aren't saved in maze.
+typedef struct {
+  // path of queries file or NULL
+  char *queries_path;
+  // whether input holds multiple mazes
+  bool multiple;
+  // path of file for distances from start position or NULL
+  char *distances_path;
+  DistancesFormat distances_format;
+  // whether connected components are labelled before search
+  bool components;
+  // path of file with saved components or NULL
+  char *components_path;
+  // path of file with wall edits or NULL
+  char *edits_path;
+  // path of binary file with maze read instead of standard input or NULL
+  char *binary_path;
+  // path of binary file to which maze is converted or NULL
+  char *output_binary_path;
+} Options;
+
+// Names of solvers accepted by --solver option.
+static const struct {
+  const char *name;
+  Solver solver;
+} solver_names[] = {
+    {"bfs", SOLVER_BFS},
+    {"bidirectional", SOLVER_BIDIRECTIONAL},
+    {"hybrid", SOLVER_HYBRID},
+    {"bitparallel", SOLVER_BITPARALLEL},
+    {"astar", SOLVER_ASTAR},
+};
+
+// Names of layouts accepted by --layout option.
+static const struct {
+  const char *name;
+  Layout layout;
+} layout_names[] = {
+    {"row-major", LAYOUT_ROW_MAJOR},
+    {"z-order", LAYOUT_Z_ORDER},
+};
+
+// Prints program usage to standard error.
+static void print_usage(char *program) {
+  fprintf(stderr,
+          "Usage: %s [-t threads] "
+          "[-s bfs|bidirectional|hybrid|bitparallel|astar] "
+          "[-l row-major|z-order] "
+          "[-q queries | -m | -D distances [-L] | -w edits | -B output] "
+          "[-b maze] "
+          "[-c | -C components] [-M bytes] [-p] [-S]\n",
+          program);
+}
+
+// Sets solver with given name. Returns false if it doesn't exist.
+static bool read_solver(Maze *maze, char *name) {
+  for (size_t i = 0; i < sizeof(solver_names) / sizeof(solver_names[0]);
+       i++) {
+    if (strcmp(name, solver_names[i].name) == 0) {
+      maze_set_solver(maze, solver_names[i].solver);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Sets layout with given name. Returns false if it doesn't exist.
+static bool read_layout(Maze *maze, char *name) {
+  for (size_t i = 0; i < sizeof(layout_names) / sizeof(layout_names[0]);
+       i++) {
+    if (strcmp(name, layout_names[i].name) == 0) {
+      maze_set_layout(maze, layout_names[i].layout);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Reads number of bytes, optionally followed by K, M or G, and limits
+// memory of bfs levels to it. Returns false if it's incorrect.
+static bool read_memory_limit(char *text) {
+  char *end = NULL;
+  size_t bytes = strtoull(text, &end, 10);
+  if (*text == '\0' || end == text) {
+    return false;
+  }
+
+  const char *units = "KMG";
+  char *unit = *end != '\0' ? strchr(units, *end) : NULL;
+  if (unit != NULL) {
+    for (long i = 0; i <= unit - units; i++) {
+      bytes = safe_product(bytes, 1024);
+    }
+    ++end;
+  }
+  if (*end != '\0') {
+    return false;
+  }
+
+  // bfs keeps the current and the next level
+  frontier_set_memory_limit(bytes / 2);
+
+  return true;
+}
+
+// Reads program options. Returns false if they're incorrect. Options
+// other than those of maze are saved to options.
+static bool read_options(int argc, char **argv, Maze *maze,
+                         Options *options) {
+  static struct option long_options[] = {
+      {"threads", required_argument, 0, 't'},
+      {"solver", required_argument, 0, 's'},
+      {"layout", required_argument, 0, 'l'},
+      {"queries", required_argument, 0, 'q'},
+      {"multiple", no_argument, 0, 'm'},
+      {"distances", required_argument, 0, 'D'},
+      {"levels", no_argument, 0, 'L'},
+      {"components", no_argument, 0, 'c'},
+      {"components-file", required_argument, 0, 'C'},
+      {"memory-limit", required_argument, 0, 'M'},
+      {"wall-edits", required_argument, 0, 'w'},
+      {"binary", required_argument, 0, 'b'},
+      {"write-binary", required_argument, 0, 'B'},
+      {"path", no_argument, 0, 'p'},
+      {"stats", no_argument, 0, 'S'},
+      {0, 0, 0, 0},
+  };
+
+  int option;
+  while ((option = getopt_long(argc, argv, "t:s:l:q:mD:LcC:M:w:b:B:pS",
+                               long_options, NULL)) != -1) {
+    char *end = NULL;
+    switch (option) {
+      case 't':
+        parallel_set_threads(strtoull(optarg, &end, 10));
+        if (*optarg == '\0' || *end != '\0') {
+          return false;
+        }
+        break;
+      case 's':
+        if (!read_solver(maze, optarg)) {
+          return false;
+        }
+        break;
+      case 'l':
+        if (!read_layout(maze, optarg)) {
+          return false;
+        }
+        break;
+      case 'q':
+        options->queries_path = optarg;
+        break;
+      case 'm':
+        options->multiple = true;
+        break;
+      case 'D':
+        options->distances_path = optarg;
+        break;
+      case 'L':
+        options->distances_format = DISTANCES_LEVELS;
+        break;
+      case 'c':
+        options->components = true;
+        break;
+      case 'C':
+        options->components = true;
+        options->components_path = optarg;
+        break;
+      case 'M':
+        if (!read_memory_limit(optarg)) {
+          return false;
+        }
+        break;
+      case 'w':
+        options->edits_path = optarg;
+        break;
+      case 'b':
+        options->binary_path = optarg;
+        break;
+      case 'B':
+        options->output_binary_path = optarg;
+        break;
+      case 'p':
+        maze_set_print_path(maze, true);
+        break;
+      case 'S':
+        stats_enable();
+        break;
+      default:
+        return false;
+    }
+  }
+
+  // at most one of queries, multiple mazes, distances, wall edits and
+  // conversion can be chosen
+  int modes = (options->queries_path != NULL) + options->multiple +
+              (options->distances_path != NULL) +
+              (options->edits_path != NULL) +
+              (options->output_binary_path != NULL);
+
+  return optind == argc && modes <= 1 &&
+         (options->distances_format == DISTANCES_MAP ||
+          options->distances_path != NULL) &&
+         !(options->multiple && (options->components_path != NULL ||
+                                 options->binary_path != NULL));
+}
+
+// Enables statistics if LABYRINTH_STATS environment variable is set to
+// anything other than an empty string or 0.
+static void read_environment() {
+  char *stats = getenv("LABYRINTH_STATS");
+  if (stats != NULL && *stats != '\0' && strcmp(stats, "0") != 0) {
+    stats_enable();
+  }
+}
+
+// Labels connected components of maze, if options say so. Components
+// saved in a file are read from it, if they match maze. Otherwise, they
+// are saved there after labelling, and ERROR 8 is printed if that fails.
+static void prepare_components(Maze *maze, Options *options) {
+  if (!options->components) {
+    return;
+  }
+
+  stats_start(PHASE_WALLS);
+  Components *components = NULL;
+  if (options->components_path != NULL) {
+    components = components_load(maze, options->components_path);
+  }
+  if (components == NULL) {
+    components = components_create(maze);
+    if (components != NULL && options->components_path != NULL &&
+        !components_save(components, options->components_path)) {
+      print_error(8);
+    }
+  }
+  maze_set_components(maze, components);
+  stats_stop(PHASE_WALLS);
+}
+
+// Prints length of a path or NO WAY if it's MAZE_NO_WAY.
+static void print_length(size_t length) {
+  if (length != MAZE_NO_WAY) {
+    printf("%zu\n", length);
+  } else {
+    printf("NO WAY\n");
+  }
+}
+
+// Prints length of the shortest path of maze, and again after every group
+// of wall edits from file with given path. Distances from start position
+// are repaired after every edit instead of searching again. If maze is
+// too large or its walls are given by a generator for at least 2^36
+// positions, prints ERROR 9.
+static void solve_with_edits(Maze *maze, char *path) {
+  Vector *edits = vector_create();
+  if (!read_wall_edits(maze, path, edits)) {
+    vector_free(edits);
+    return;
+  }
+
+  stats_start(PHASE_SEARCH);
+  DynamicMaze *dynamic = dynamic_create(maze);
+  if (dynamic == NULL) {
+    print_error(9);
+  } else {
+    print_length(dynamic_path_length(dynamic));
+    for (size_t i = 0; i < vector_size(edits); i++) {
+      if (vector_get(edits, i) == EDITS_GROUP_END) {
+        print_length(dynamic_path_length(dynamic));
+      } else {
+        dynamic_toggle_wall(dynamic, vector_get(edits, i));
+      }
+    }
+  }
+  stats_stop(PHASE_SEARCH);
+
+  dynamic_free(dynamic);
+  vector_free(edits);
+}
+
+// Reads maze from binary file, if options give it, or from standard
+// input. If it's incorrect, prints error and returns false.
+static bool read_input(Maze *maze, Options *options) {
+  if (options->binary_path == NULL) {
+    return read_maze_data(maze);
+  }
+
+  stats_start(PHASE_WALLS);
+  bool correct = mazefile_read(maze, options->binary_path);
+  stats_stop(PHASE_WALLS);
+  if (!correct) {
+    print_error(10);
+  }
+
+  return correct;
+}
+
+// Solves mazes that follow one another on standard input and prints one
+// answer per maze. Incorrect maze gets ERROR with number of its first
+// incorrect line as its answer. Maze is reused for every one of them.
+static void solve_multiple(Maze *maze, Options *options) {
+  int err;
+  while ((err = read_next_maze(maze)) != INPUT_END) {
+    if (err) {
+      printf("ERROR %d\n", err);
+    } else {
+      prepare_components(maze, options);
+      maze_solve(maze);
+    }
+    maze_clear(maze);
+  }
+}
+
+int main(int argc, char **argv) {
   Maze *maze = maze_create();
+  Options options = {NULL, false, NULL, DISTANCES_MAP, false,
+                     NULL, NULL,  NULL, NULL};
+
+  read_environment();
 
-  if (read_maze_data(maze)) {
-    maze_solve(maze);
+  if (!read_options(argc, argv, maze, &options)) {
+    print_usage(argv[0]);
+    maze_free(maze);
+    return 1;
+  }
+
+  if (options.multiple) {
+    solve_multiple(maze, &options);
+  } else if (read_input(maze, &options)) {
+    if (stats_enabled()) {
+      stats_set_wall_density(bitset_density(maze_walls(maze)));
+    }
+    if (options.edits_path == NULL && options.output_binary_path == NULL) {
+      prepare_components(maze, &options);
+    }
+
+    if (options.output_binary_path != NULL) {
+      if (!mazefile_write(maze, options.output_binary_path)) {
+        print_error(10);
+      }
+    } else if (options.edits_path != NULL) {
+      solve_with_edits(maze, options.edits_path);
+    } else if (options.distances_path != NULL) {
+      stats_start(PHASE_SEARCH);
+      if (!distances_write(maze, options.distances_path,
+                           options.distances_format)) {
+        print_error(7);
+      }
+      stats_stop(PHASE_SEARCH);
+    } else if (options.queries_path == NULL) {
+      maze_solve(maze);
+    } else {
+      Vector *queries = vector_create();
+      if (read_queries(maze, options.queries_path, queries)) {
+        batch_solve(maze, queries);
+      }
+      vector_free(queries);
+    }
   }
 
   maze_free(maze);
 
+  if (stats_enabled()) {
+    stats_print();
+  }
+
   return 0;
 }
@@ -1,14 +1,38 @@
 #include "maze.h"
 #include <stdio.h>
+#include "astar.h"
+#include "bidirectional_bfs.h"
+#include "bitparallel_bfs.h"
+#include "components.h"
+#include "frontier.h"
+#include "grid.h"
+#include "grid_bfs.h"
+#include "hybrid_bfs.h"
+#include "parallel.h"
+#include "parallel_bfs.h"
+#include "path.h"
+#include "sparse_bfs.h"
+#include "stats.h"
 #include "utils.h"
+#include "zgrid.h"
 
 struct Maze {
   Vector *dimensions;
   Vector *start_position;
   Vector *end_position;
   Bitset *walls;
+  Components *components;
   uint64_t start_position_hash;
   uint64_t end_position_hash;
+  Solver solver;
+  Layout layout;
+  bool print_path;
+  // storage of searches, kept when another maze is set and cleared
+  // instead of being freed
+  Bitset *visited;
+  Frontier *frontiers[2];
+  // walls of the previous maze, reused for walls of the next one
+  Bitset *spare_walls;
 };
 
 // Checks if position is correct and inside maze.
@@ -33,11 +57,6 @@ static bool is_position_free(Maze *maze, size_t position_hash) {
   return !bitset_get(maze->walls, position_hash);
 }
 
-// Changes position to wall.
-static void set_wall(Maze *maze, size_t position_hash) {
-  bitset_set(maze->walls, position_hash);
-}
-
 // Returns hash of a position.
 static size_t hash_position(Maze *maze, Vector *position) {
   size_t hash = 0, N = 1;
@@ -59,9 +78,13 @@ static void dehash_position(Maze *maze, uint64_t hash, Vector *result) {
   }
 }
 
-// Adds all possible to visit adjacent positions to passed vector.
+// Adds all possible to visit adjacent positions to passed vector and
+// marks them as visited. Adds number of checked neighbours inside maze to
+// neighbour_checks.
 static bool process_adjacent_positions(Maze *maze, Vector *position,
-                                       size_t position_hash, Vector *next) {
+                                       size_t position_hash, Bitset *visited,
+                                       Frontier *next,
+                                       size_t *neighbour_checks) {
   size_t N = 1;
   for (size_t i = 0; i < vector_size(maze->dimensions); i++) {
     for (size_t j = 0; j <= 1; j++) {
@@ -69,8 +92,14 @@ static bool process_adjacent_positions(Maze *maze, Vector *position,
       size_t next_position_hash = position_hash - N * !j + N * j;
       size_t z_i = vector_get(position, i) - !j + j;
 
-      // check if position shouldn't be processed
-      if (z_i < 1 || z_i > vector_get(maze->dimensions, i) ||
+      // check if position is outside maze
+      if (z_i < 1 || z_i > vector_get(maze->dimensions, i)) {
+        continue;
+      }
+
+      // check if position was visited or is a wall
+      ++*neighbour_checks;
+      if (bitset_get(visited, next_position_hash) ||
           !is_position_free(maze, next_position_hash)) {
         continue;
       }
@@ -81,8 +110,8 @@ static bool process_adjacent_positions(Maze *maze, Vector *position,
       }
 
       // process position
-      vector_push_back(next, next_position_hash);
-      set_wall(maze, next_position_hash);
+      frontier_push(next, next_position_hash);
+      bitset_set(visited, next_position_hash);
     }
 
     N *= vector_get(maze->dimensions, i);
@@ -91,49 +120,119 @@ static bool process_adjacent_positions(Maze *maze, Vector *position,
   return false;
 }
 
+// Records bfs level, whose expansion took given number of positions from
+// current frontier and checked given number of their neighbours, in
+// statistics.
+static void record_level(size_t expanded, size_t neighbour_checks,
+                         Frontier *current, Frontier *next) {
+  stats_level(expanded, neighbour_checks,
+              frontier_bytes(current) + frontier_bytes(next));
+}
+
 // Finds length of the shortest path from start to end position
 // and returns it. If it doesn't exist, returns 0. Assumes that
-// start and end positions are not equal.
+// start and end positions are not equal. Mazes too large for a grid keep
+// visited positions in a separate bitset, whose memory is committed only
+// where positions are visited.
 static size_t find_shortest_path(Maze *maze) {
+  if (maze->layout == LAYOUT_Z_ORDER && maze->solver == SOLVER_BFS &&
+      maze_size(maze) < GRID_SIZE_MAX) {
+    ZGrid *zgrid = zgrid_create(maze);
+    if (zgrid != NULL) {
+      size_t answer = zgrid_find_shortest_path(maze, zgrid);
+      zgrid_free(zgrid);
+
+      return answer;
+    }
+  }
+
+  Grid *grid = maze_size(maze) < GRID_SIZE_MAX ? grid_create(maze) : NULL;
+  if (grid != NULL) {
+    size_t answer = maze->solver == SOLVER_BITPARALLEL
+                        ? bitparallel_find_shortest_path(grid)
+                        : grid_bfs_find_shortest_path(maze, grid);
+    grid_free(grid);
+
+    return answer;
+  }
+
   size_t answer = 0, depth = 0;
 
   // will store hashes of positions
-  Vector *current_depth_positions = vector_create();
-  Vector *next_depth_positions = vector_create();
+  Frontier *current_depth_positions, *next_depth_positions;
+  maze_frontiers(maze, maze_size(maze), &current_depth_positions,
+                 &next_depth_positions);
 
   // will store coordinates of current position
   Vector *position = vector_create();
+  Bitset *visited = maze_visited(maze, maze_size(maze));
 
   // initialize bfs using start position
-  vector_push_back(current_depth_positions, maze->start_position_hash);
-  set_wall(maze, maze->start_position_hash);
+  frontier_push(current_depth_positions, maze->start_position_hash);
+  bitset_set(visited, maze->start_position_hash);
 
-  while (!answer && !vector_is_empty(current_depth_positions)) {
+  size_t expanded = 0, neighbour_checks = 0;
+  while (!answer && !frontier_is_empty(current_depth_positions)) {
     // current position
-    uint64_t position_hash = vector_pop_back(current_depth_positions);
+    uint64_t position_hash = frontier_pop(current_depth_positions);
     dehash_position(maze, position_hash, position);
+    ++expanded;
 
     // add adjacent positions to next_depth_positions
-    if (process_adjacent_positions(maze, position, position_hash,
-                                   next_depth_positions)) {
+    if (process_adjacent_positions(maze, position, position_hash, visited,
+                                   next_depth_positions, &neighbour_checks)) {
       // end position is adjacent to current position
       answer = depth + 1;
     }
 
     // check if all positions of current depth were visited
-    if (vector_is_empty(current_depth_positions)) {
+    if (frontier_is_empty(current_depth_positions)) {
+      record_level(expanded, neighbour_checks, current_depth_positions,
+                   next_depth_positions);
+      expanded = neighbour_checks = 0;
       ++depth;
       swap((void **)&current_depth_positions, (void **)&next_depth_positions);
     }
   }
 
-  vector_free(current_depth_positions);
-  vector_free(next_depth_positions);
+  if (expanded > 0) {
+    record_level(expanded, neighbour_checks, current_depth_positions,
+                 next_depth_positions);
+  }
+
   vector_free(position);
 
   return answer;
 }
 
+// Finds length of the shortest path from start to end position with
+// selected solver and returns it. If it doesn't exist, returns 0.
+// Assumes that start and end positions are not equal.
+static size_t find_path_length(Maze *maze) {
+  if (maze_dimensions_number(maze) == 1) {
+    // walls between both positions decide
+    return line_find_shortest_path(maze);
+  } else if (bitset_is_periodic(maze->walls)) {
+    // other solvers need walls of every position stored
+    return sparse_find_shortest_path(maze);
+  } else if (bitset_is_compressed(maze->walls)) {
+    // A* only tests single positions, while other solvers build grids
+    // or scan words of walls
+    return maze->solver == SOLVER_ASTAR ? astar_find_shortest_path(maze)
+                                        : find_shortest_path(maze);
+  } else if (maze->solver == SOLVER_BIDIRECTIONAL) {
+    return bidirectional_find_shortest_path(maze);
+  } else if (maze->solver == SOLVER_ASTAR) {
+    return astar_find_shortest_path(maze);
+  } else if (maze->solver == SOLVER_HYBRID) {
+    return hybrid_find_shortest_path(maze);
+  } else if (maze->solver == SOLVER_BFS && parallel_threads() > 1) {
+    return parallel_find_shortest_path(maze);
+  }
+
+  return find_shortest_path(maze);
+}
+
 Maze *maze_create() {
   Maze *maze = (Maze *)safe_calloc(1, sizeof(Maze));
   return maze;
@@ -141,14 +240,31 @@ Maze *maze_create() {
 
 void maze_free(Maze *maze) {
   if (maze != NULL) {
-    vector_free(maze->dimensions);
-    vector_free(maze->start_position);
-    vector_free(maze->end_position);
-    bitset_free(maze->walls);
+    maze_clear(maze);
+    bitset_free(maze->visited);
+    frontier_free(maze->frontiers[0]);
+    frontier_free(maze->frontiers[1]);
+    bitset_free(maze->spare_walls);
     free(maze);
   }
 }
 
+void maze_clear(Maze *maze) {
+  vector_free(maze->dimensions);
+  vector_free(maze->start_position);
+  vector_free(maze->end_position);
+  bitset_free(maze->spare_walls);
+  maze->spare_walls = maze->walls;
+  components_free(maze->components);
+  maze->dimensions = NULL;
+  maze->start_position = NULL;
+  maze->end_position = NULL;
+  maze->walls = NULL;
+  maze->components = NULL;
+  maze->start_position_hash = 0;
+  maze->end_position_hash = 0;
+}
+
 size_t maze_size(Maze *maze) {
   size_t size = 1;
   for (size_t i = 0; i < vector_size(maze->dimensions); i++) {
@@ -198,6 +314,28 @@ bool maze_set_walls(Maze *maze, Bitset *walls) {
   return walls != NULL;
 }
 
+void maze_compress_walls(Maze *maze) {
+  if (maze_size(maze) >= GRID_SIZE_MAX) {
+    bitset_compress(maze->walls);
+  }
+}
+
+void maze_set_solver(Maze *maze, Solver solver) {
+  maze->solver = solver;
+}
+
+void maze_set_components(Maze *maze, Components *components) {
+  components_free(maze->components);
+  maze->components = components;
+}
+
+bool maze_may_be_connected(Maze *maze, size_t position_hash1,
+                           size_t position_hash2) {
+  return maze->components == NULL ||
+         components_connected(maze->components, position_hash1,
+                              position_hash2);
+}
+
 bool maze_is_start_position_free(Maze *maze) {
   return is_position_free(maze, maze->start_position_hash);
 }
@@ -206,16 +344,147 @@ bool maze_is_end_position_free(Maze *maze) {
   return is_position_free(maze, maze->end_position_hash);
 }
 
-void maze_solve(Maze *maze) {
+void maze_set_layout(Maze *maze, Layout layout) {
+  maze->layout = layout;
+}
+
+void maze_set_print_path(Maze *maze, bool print_path) {
+  maze->print_path = print_path;
+}
+
+void maze_position(Maze *maze, size_t position_hash, Vector *position) {
+  dehash_position(maze, position_hash, position);
+}
+
+size_t maze_neighbours(Maze *maze, size_t position_hash, size_t *neighbours) {
+  size_t neighbours_number = 0, rest = position_hash, N = 1;
+  for (size_t i = 0; i < vector_size(maze->dimensions); i++) {
+    uint64_t n_i = vector_get(maze->dimensions, i);
+    uint64_t z_i = rest % n_i;
+    rest /= n_i;
+
+    if (z_i > 0) {
+      neighbours[neighbours_number++] = position_hash - N;
+    }
+    if (z_i + 1 < n_i) {
+      neighbours[neighbours_number++] = position_hash + N;
+    }
+
+    N *= n_i;
+  }
+
+  return neighbours_number;
+}
+
+bool maze_position_hash(Maze *maze, Vector *position, size_t *hash) {
+  if (!is_position_valid(maze, position)) {
+    return false;
+  }
+
+  *hash = hash_position(maze, position);
+
+  return true;
+}
+
+bool maze_free_position_hash(Maze *maze, Vector *position, size_t *hash) {
+  if (!is_position_valid(maze, position)) {
+    return false;
+  }
+
+  *hash = hash_position(maze, position);
+
+  return is_position_free(maze, *hash);
+}
+
+size_t maze_dimensions_number(Maze *maze) {
+  return vector_size(maze->dimensions);
+}
+
+uint64_t maze_dimension(Maze *maze, size_t i) {
+  return vector_get(maze->dimensions, i);
+}
+
+Bitset *maze_walls(Maze *maze) {
+  return maze->walls;
+}
+
+Bitset *maze_take_spare_walls(Maze *maze) {
+  Bitset *walls = maze->spare_walls;
+  maze->spare_walls = NULL;
+
+  return walls;
+}
+
+Bitset *maze_visited(Maze *maze, size_t size) {
+  maze->visited = bitset_recreate(maze->visited, size);
+  return maze->visited;
+}
+
+void maze_frontiers(Maze *maze, size_t size, Frontier **current,
+                    Frontier **next) {
+  for (size_t i = 0; i < 2; i++) {
+    if (maze->frontiers[i] == NULL) {
+      maze->frontiers[i] = frontier_create(size);
+    } else {
+      frontier_reset(maze->frontiers[i], size);
+    }
+  }
+
+  *current = maze->frontiers[0];
+  *next = maze->frontiers[1];
+}
+
+size_t maze_start_position_hash(Maze *maze) {
+  return maze->start_position_hash;
+}
+
+size_t maze_end_position_hash(Maze *maze) {
+  return maze->end_position_hash;
+}
+
+size_t maze_shortest_path_length(Maze *maze) {
   if (maze->start_position_hash == maze->end_position_hash) {
-    printf("0\n");
-    return;
+    return 0;
+  } else if (!maze_may_be_connected(maze, maze->start_position_hash,
+                                    maze->end_position_hash)) {
+    return MAZE_NO_WAY;
   }
 
-  size_t path_length = find_shortest_path(maze);
-  if (path_length != 0) {
-    printf("%zu\n", path_length);
+  size_t path_length = find_path_length(maze);
+
+  return path_length != 0 ? path_length : MAZE_NO_WAY;
+}
+
+size_t maze_path_length(Maze *maze, size_t start_position_hash,
+                        size_t end_position_hash) {
+  size_t saved_start = maze->start_position_hash;
+  size_t saved_end = maze->end_position_hash;
+  maze->start_position_hash = start_position_hash;
+  maze->end_position_hash = end_position_hash;
+
+  size_t path_length = maze_shortest_path_length(maze);
+
+  maze->start_position_hash = saved_start;
+  maze->end_position_hash = saved_end;
+
+  return path_length;
+}
+
+void maze_solve(Maze *maze) {
+  stats_start(PHASE_SEARCH);
+
+  bool connected = maze_may_be_connected(maze, maze->start_position_hash,
+                                         maze->end_position_hash);
+  if (maze->print_path && connected) {
+    path_print_shortest_path(maze);
   } else {
-    printf("NO WAY\n");
+    size_t path_length = maze_shortest_path_length(maze);
+    if (path_length != MAZE_NO_WAY) {
+      printf("%zu\n", path_length);
+    } else {
+      printf("NO WAY\n");
+    }
   }
+
+  stats_stop(PHASE_SEARCH);
 }
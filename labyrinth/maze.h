@@ -2,17 +2,45 @@
 #define MAZE_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "bitset.h"
 #include "vector.h"
 
 typedef struct Maze Maze;
 
+typedef struct Components Components;
+
+typedef struct Frontier Frontier;
+
+// Algorithms which can be used to find the shortest path.
+typedef enum {
+  SOLVER_BFS,
+  SOLVER_BIDIRECTIONAL,
+  SOLVER_HYBRID,
+  SOLVER_BITPARALLEL,
+  SOLVER_ASTAR,
+} Solver;
+
+// Orders in which bfs solver stores maze positions.
+typedef enum {
+  // by hash, so that neighbours in the first dimension are adjacent
+  LAYOUT_ROW_MAJOR,
+  // by interleaved bits of coordinates, so that neighbours in every
+  // dimension are close
+  LAYOUT_Z_ORDER,
+} Layout;
+
 // Creates empty maze.
 Maze *maze_create();
 
 // Frees all allocated memory of passed maze.
 void maze_free(Maze *maze);
 
+// Frees dimensions and positions of maze, so that another maze can be
+// set. Solver, layout and path printing stay set. Walls and storage of
+// searches are kept and reused for the next maze.
+void maze_clear(Maze *maze);
+
 // Returns maze size, i.e. product of its dimensions. If it
 // exceeds SIZE_MAX, returns SIZE_MAX.
 size_t maze_size(Maze *maze);
@@ -29,14 +57,101 @@ bool maze_set_end_position(Maze *maze, Vector *position);
 // Sets maze walls and checks if they're correct.
 bool maze_set_walls(Maze *maze, Bitset *walls);
 
+// Compresses walls of a maze too large for a grid, if that saves memory.
+// Such maze is then searched by single-threaded bfs, regardless of solver
+// and number of threads, since its walls can only be read.
+void maze_compress_walls(Maze *maze);
+
+// Sets algorithm used by maze_solve. By default, SOLVER_BFS is used.
+void maze_set_solver(Maze *maze, Solver solver);
+
+// Sets order of positions used by single-threaded bfs solver. By default,
+// LAYOUT_ROW_MAJOR is used.
+void maze_set_layout(Maze *maze, Layout layout);
+
+// Sets if maze_solve prints positions of the shortest path after its
+// length. By default, it doesn't.
+void maze_set_print_path(Maze *maze, bool print_path);
+
+// Sets connected components of maze walls, which answer queries about
+// positions in different components without a search. Maze takes
+// ownership of components. By default, there are none.
+void maze_set_components(Maze *maze, Components *components);
+
+// Checks if a path between free positions with given hashes may exist,
+// i.e. components aren't set or both positions are in the same one.
+bool maze_may_be_connected(Maze *maze, size_t position_hash1,
+                           size_t position_hash2);
+
 // Checks if start position is free.
 bool maze_is_start_position_free(Maze *maze);
 
 // Checks if end position is free.
 bool maze_is_end_position_free(Maze *maze);
 
+// Checks if position is inside maze and free. If so, saves its hash.
+// Doesn't take ownership of position.
+bool maze_free_position_hash(Maze *maze, Vector *position, size_t *hash);
+
+// Checks if position is inside maze. If so, saves its hash. Doesn't take
+// ownership of position.
+bool maze_position_hash(Maze *maze, Vector *position, size_t *hash);
+
+// Saves coordinates of position with given hash to position.
+void maze_position(Maze *maze, size_t position_hash, Vector *position);
+
+// Saves hashes of positions adjacent to position with given hash, walls
+// included, to neighbours and returns their number. Neighbours must have
+// space for 2 * maze_dimensions_number(maze) hashes.
+size_t maze_neighbours(Maze *maze, size_t position_hash, size_t *neighbours);
+
+// Returns number of maze dimensions.
+size_t maze_dimensions_number(Maze *maze);
+
+// Returns size of i-th maze dimension.
+uint64_t maze_dimension(Maze *maze, size_t i);
+
+// Returns maze walls.
+Bitset *maze_walls(Maze *maze);
+
+// Returns walls of the maze cleared before, whose memory can be reused
+// for walls of this one, or NULL. Caller takes them over.
+Bitset *maze_take_spare_walls(Maze *maze);
+
+// Returns empty bitset with given size for visited positions of
+// a search. Its memory belongs to maze and is reused by later searches,
+// also of the next mazes, so only one search can use it at a time.
+Bitset *maze_visited(Maze *maze, size_t size);
+
+// Saves two empty frontiers for hashes smaller than size to current and
+// next. Like the visited bitset, they belong to maze and are reused.
+void maze_frontiers(Maze *maze, size_t size, Frontier **current,
+                    Frontier **next);
+
+// Returns hash of start position.
+size_t maze_start_position_hash(Maze *maze);
+
+// Returns hash of end position.
+size_t maze_end_position_hash(Maze *maze);
+
+// Value of maze_shortest_path_length if the path doesn't exist.
+#define MAZE_NO_WAY SIZE_MAX
+
+// Returns length of the shortest path from start to end position with
+// selected solver or MAZE_NO_WAY if it doesn't exist. Doesn't print
+// anything, regardless of path printing. Maze walls are left intact, so
+// it can be called again.
+size_t maze_shortest_path_length(Maze *maze);
+
+// Returns length of the shortest path between positions with given
+// hashes like maze_shortest_path_length, which searches it in place of
+// start and end position. Assumes that both positions are free.
+size_t maze_path_length(Maze *maze, size_t start_position_hash,
+                        size_t end_position_hash);
+
 // Prints length of the shortest path from start to end position or
-// prints NO WAY if it doesn't exist.
+// prints NO WAY if it doesn't exist. If path printing is set, prints
+// coordinates of its positions afterwards, one position per line.
 void maze_solve(Maze *maze);
 
 #endif  // MAZE_H
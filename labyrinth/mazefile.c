@@ -0,0 +1,197 @@
+#define _DEFAULT_SOURCE
+
+#include "mazefile.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bitset.h"
+#include "utils.h"
+#include "vector.h"
+
+// Version of the file format.
+#define VERSION 1
+
+// Number of 64-bit header fields other than dimensions.
+#define HEADER_FIELDS 7
+
+// Walls start at a multiple of this offset, so that they can be mapped
+// with any common page size.
+#define WALLS_ALIGNMENT (1 << 16)
+
+// Words of compressed walls extracted for one write.
+#define BLOCK_WORDS (1 << 16)
+
+// Encodings of walls.
+enum {
+  WALLS_FULL,
+  WALLS_PERIODIC,
+};
+
+// Writes n bytes from data to fd at given offset. Returns false if it
+// fails.
+static bool write_all(int fd, const void *data, size_t n, size_t offset) {
+  const char *bytes = (const char *)data;
+  while (n > 0) {
+    ssize_t written = pwrite(fd, bytes, n, (off_t)offset);
+    if (written <= 0) {
+      return false;
+    }
+    bytes += written;
+    n -= (size_t)written;
+    offset += (size_t)written;
+  }
+
+  return true;
+}
+
+// Reads n bytes from fd at given offset to data. Returns false if it
+// fails.
+static bool read_all(int fd, void *data, size_t n, size_t offset) {
+  char *bytes = (char *)data;
+  while (n > 0) {
+    ssize_t length = pread(fd, bytes, n, (off_t)offset);
+    if (length <= 0) {
+      return false;
+    }
+    bytes += length;
+    n -= (size_t)length;
+    offset += (size_t)length;
+  }
+
+  return true;
+}
+
+// Returns offset of walls after header for k dimensions.
+static size_t walls_offset(size_t k) {
+  size_t header_bytes = (HEADER_FIELDS + k) * sizeof(uint64_t);
+
+  return (header_bytes + WALLS_ALIGNMENT - 1) / WALLS_ALIGNMENT *
+         WALLS_ALIGNMENT;
+}
+
+// Writes words of walls to file fd from given offset. Words of compressed
+// walls are extracted block by block. Returns false if it fails.
+static bool write_walls(int fd, Bitset *walls, size_t offset) {
+  size_t words_number = bitset_words_number(walls);
+  if (!bitset_is_compressed(walls)) {
+    return write_all(fd, bitset_data(walls),
+                     words_number * sizeof(uint64_t), offset);
+  }
+
+  uint64_t *block = (uint64_t *)safe_malloc(BLOCK_WORDS * sizeof(uint64_t));
+  bool written = true;
+  for (size_t w = 0; written && w < words_number; w += BLOCK_WORDS) {
+    size_t n = words_number - w < BLOCK_WORDS ? words_number - w
+                                              : BLOCK_WORDS;
+    for (size_t i = 0; i < n; i++) {
+      block[i] = bitset_word(walls, w + i);
+    }
+    written = write_all(fd, block, n * sizeof(uint64_t),
+                        offset + w * sizeof(uint64_t));
+  }
+  free(block);
+
+  return written;
+}
+
+bool mazefile_write(Maze *maze, const char *path) {
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+
+  size_t k = maze_dimensions_number(maze);
+  Bitset *walls = maze_walls(maze);
+  uint64_t *header =
+      (uint64_t *)safe_calloc(HEADER_FIELDS + k, sizeof(uint64_t));
+  memcpy(&header[0], "LABMAZE", 8);
+  header[1] = VERSION;
+  header[2] = k;
+  header[3] = bitset_is_periodic(walls) ? WALLS_PERIODIC : WALLS_FULL;
+  header[4] = walls_offset(k);
+  for (size_t i = 0; i < k; i++) {
+    header[5 + i] = maze_dimension(maze, i);
+  }
+  header[5 + k] = maze_start_position_hash(maze);
+  header[6 + k] = maze_end_position_hash(maze);
+
+  bool written =
+      write_all(fd, header, (HEADER_FIELDS + k) * sizeof(uint64_t), 0) &&
+      write_walls(fd, walls, walls_offset(k));
+  free(header);
+
+  return close(fd) == 0 && written;
+}
+
+// Sets dimensions and positions of maze from header. Returns false if
+// they're incorrect.
+static bool set_header(Maze *maze, uint64_t *header, size_t k) {
+  Vector *dimensions = vector_create();
+  for (size_t i = 0; i < k; i++) {
+    vector_push_back(dimensions, header[5 + i]);
+  }
+  if (!maze_set_dimensions(maze, dimensions)) {
+    return false;
+  }
+
+  size_t size = maze_size(maze);
+  if (size == SIZE_MAX || header[5 + k] >= size || header[6 + k] >= size) {
+    return false;
+  }
+
+  Vector *start_position = vector_create();
+  maze_position(maze, header[5 + k], start_position);
+  Vector *end_position = vector_create();
+  maze_position(maze, header[6 + k], end_position);
+
+  // end position is set even if start position is incorrect, so it's freed
+  bool correct = maze_set_start_position(maze, start_position);
+  return maze_set_end_position(maze, end_position) && correct;
+}
+
+bool mazefile_read(Maze *maze, const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat file_stat;
+  size_t file_words = fstat(fd, &file_stat) == 0
+                          ? (size_t)file_stat.st_size / sizeof(uint64_t)
+                          : 0;
+
+  // number of dimensions of a corrupt file is bounded by the file size, so
+  // that its header is never allocated larger than the file
+  uint64_t fields[5] = {0};
+  bool correct = read_all(fd, fields, sizeof(fields), 0) &&
+                 memcmp(&fields[0], "LABMAZE", 8) == 0 &&
+                 fields[1] == VERSION && fields[2] > 0 &&
+                 fields[2] <= file_words &&
+                 file_words - fields[2] >= HEADER_FIELDS &&
+                 fields[3] <= WALLS_PERIODIC &&
+                 fields[4] == walls_offset(fields[2]);
+
+  size_t k = correct ? fields[2] : 0;
+  uint64_t *header = (uint64_t *)safe_calloc(HEADER_FIELDS + k,
+                                             sizeof(uint64_t));
+  correct = correct &&
+            read_all(fd, header, (HEADER_FIELDS + k) * sizeof(uint64_t), 0) &&
+            set_header(maze, header, k);
+
+  free(header);
+
+  // the file must hold all words of walls before they're mapped
+  if (correct) {
+    bool periodic = fields[3] == WALLS_PERIODIC;
+    size_t stored_size = periodic ? 1ULL << 32 : maze_size(maze);
+    correct = (size_t)file_stat.st_size >=
+                  fields[4] + (1 + stored_size / 64) * sizeof(uint64_t) &&
+              maze_set_walls(maze, bitset_map_file(fd, fields[4],
+                                                   maze_size(maze), periodic));
+  }
+  close(fd);
+
+  return correct && maze_is_start_position_free(maze) &&
+         maze_is_end_position_free(maze);
+}
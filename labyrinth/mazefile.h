@@ -0,0 +1,23 @@
+#ifndef MAZEFILE_H
+#define MAZEFILE_H
+
+#include <stdbool.h>
+#include "maze.h"
+
+// Binary maze files start with a header of 64-bit numbers in native byte
+// order: magic "LABMAZE\0", version (1), number of dimensions k, walls
+// encoding (0 for all positions, 1 for the first 2^32 positions, which
+// repeat up to maze size), offset of walls, dimensions, hash of start
+// position and hash of end position. Walls are stored from the offset,
+// a multiple of 64 KiB, as words of a bitset, so they're mapped instead
+// of being read.
+
+// Writes maze to binary file with given path. Returns false if it fails.
+bool mazefile_write(Maze *maze, const char *path);
+
+// Reads maze from binary file with given path and saves it to passed
+// maze. Walls are mapped and read from the file only when they're
+// accessed. Returns false if it can't be read or it's incorrect.
+bool mazefile_read(Maze *maze, const char *path);
+
+#endif  // MAZEFILE_H
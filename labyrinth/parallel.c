@@ -0,0 +1,63 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parallel.h"
+#include <pthread.h>
+#include <unistd.h>
+#include "utils.h"
+
+static size_t threads_number = 1;
+
+// Arguments of a single thread started by parallel_run.
+typedef struct {
+  void (*task)(void *arg, size_t id);
+  void *arg;
+  size_t id;
+} Job;
+
+static void *run_job(void *job_ptr) {
+  Job *job = (Job *)job_ptr;
+  job->task(job->arg, job->id);
+
+  return NULL;
+}
+
+void parallel_set_threads(size_t threads) {
+  if (threads == 0) {
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = online > 0 ? (size_t)online : 1;
+  }
+
+  threads_number = threads;
+}
+
+size_t parallel_threads() {
+  return threads_number;
+}
+
+void parallel_run(size_t threads, void (*task)(void *arg, size_t id),
+                  void *arg) {
+  if (threads <= 1) {
+    task(arg, 0);
+    return;
+  }
+
+  pthread_t *handles =
+      (pthread_t *)safe_calloc(threads, sizeof(pthread_t));
+  Job *jobs = (Job *)safe_calloc(threads, sizeof(Job));
+
+  for (size_t id = 1; id < threads; id++) {
+    jobs[id] = (Job){task, arg, id};
+    if (pthread_create(&handles[id], NULL, run_job, &jobs[id]) != 0) {
+      error(0);
+    }
+  }
+
+  task(arg, 0);
+
+  for (size_t id = 1; id < threads; id++) {
+    pthread_join(handles[id], NULL);
+  }
+
+  free(handles);
+  free(jobs);
+}
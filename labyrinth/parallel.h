@@ -0,0 +1,18 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+
+// Sets number of threads used by parallel algorithms. If threads is 0,
+// number of online processors is used.
+void parallel_set_threads(size_t threads);
+
+// Returns number of threads used by parallel algorithms (at least 1).
+size_t parallel_threads();
+
+// Runs task(arg, id) for every id in [0, threads) concurrently and waits
+// for all of them to finish. Task with id 0 runs in the calling thread.
+void parallel_run(size_t threads, void (*task)(void *arg, size_t id),
+                  void *arg);
+
+#endif  // PARALLEL_H
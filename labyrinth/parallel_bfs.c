@@ -0,0 +1,292 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "parallel_bfs.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+#include "bitset.h"
+#include "parallel.h"
+#include "stats.h"
+#include "utils.h"
+#include "vector.h"
+
+// Number of positions of current level claimed by a thread at once.
+#define CHUNK 1024
+
+// Levels smaller than this are expanded by a single thread, because
+// synchronizing threads would cost more than expanding them.
+#define PARALLEL_LEVEL_MIN 4096
+
+// Numbers of positions expanded and neighbours checked by a thread during
+// a level.
+typedef struct {
+  size_t expanded;
+  size_t neighbour_checks;
+} Counters;
+
+// State of a search shared by all threads.
+typedef struct {
+  Bitset *walls;
+  Bitset *visited;
+  uint64_t *dimensions;
+  size_t dimensions_number;
+  size_t end_position_hash;
+  size_t threads;
+
+  // hashes of positions of current and next depth
+  Vector *current_depth_positions;
+  Vector *next_depth_positions;
+
+  // positions of next depth found by each thread and offsets
+  // at which they're copied to next_depth_positions
+  Vector **found_positions;
+  size_t *offsets;
+  // counters of each thread, summed when the level is finished
+  Counters *counters;
+
+  // index of the first position of current depth not claimed by any thread
+  size_t claimed;
+  bool end_reached;
+
+  bool finished;
+  size_t depth;
+  size_t answer;
+  pthread_barrier_t barrier;
+} Search;
+
+// Marks position as visited and adds it to next if it's free and wasn't
+// visited before. Returns true if it's end position.
+static bool visit_position(Search *search, size_t position_hash,
+                           Vector *next) {
+  if (position_hash == search->end_position_hash) {
+    return true;
+  }
+
+  if (!bitset_get(search->walls, position_hash) &&
+      !bitset_test_and_set(search->visited, position_hash)) {
+    vector_push_back(next, position_hash);
+  }
+
+  return false;
+}
+
+// Visits all adjacent positions. Returns true if end position is one of them.
+static bool expand_position(Search *search, size_t position_hash,
+                            Vector *next, Counters *counters) {
+  size_t rest = position_hash, N = 1;
+  for (size_t i = 0; i < search->dimensions_number; i++) {
+    uint64_t n_i = search->dimensions[i];
+    uint64_t z_i = rest % n_i;
+    rest /= n_i;
+
+    // decrement and increment i-th coordinate
+    if (z_i > 0) {
+      ++counters->neighbour_checks;
+      if (visit_position(search, position_hash - N, next)) {
+        return true;
+      }
+    }
+    if (z_i + 1 < n_i) {
+      ++counters->neighbour_checks;
+      if (visit_position(search, position_hash + N, next)) {
+        return true;
+      }
+    }
+
+    N *= n_i;
+  }
+
+  return false;
+}
+
+// Expands positions with given hashes and counts them. Returns true if end
+// position was reached.
+static bool expand_positions(Search *search, uint64_t *hashes, size_t n,
+                             Vector *next, Counters *counters) {
+  for (size_t i = 0; i < n; i++) {
+    ++counters->expanded;
+    if (expand_position(search, hashes[i], next, counters)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Records level, whose next level has given size, in statistics.
+static void record_level(Search *search, Counters *counters,
+                         size_t next_level_size) {
+  size_t level_size = vector_size(search->current_depth_positions);
+  stats_level(counters->expanded, counters->neighbour_checks,
+              (level_size + next_level_size) * sizeof(uint64_t));
+}
+
+// Expands levels in the calling thread as long as they are too small
+// to be worth splitting between threads.
+static void expand_small_levels(Search *search) {
+  while (!search->finished) {
+    size_t level_size = vector_size(search->current_depth_positions);
+    if (level_size == 0) {
+      search->finished = true;
+    } else if (level_size >= PARALLEL_LEVEL_MIN) {
+      return;
+    } else {
+      vector_clear(search->next_depth_positions);
+      Counters counters = {0};
+      bool end_reached = expand_positions(
+          search, vector_data(search->current_depth_positions), level_size,
+          search->next_depth_positions, &counters);
+      record_level(search, &counters,
+                   vector_size(search->next_depth_positions));
+
+      if (end_reached) {
+        search->answer = search->depth + 1;
+        search->finished = true;
+      } else {
+        swap((void **)&search->current_depth_positions,
+             (void **)&search->next_depth_positions);
+        ++search->depth;
+      }
+    }
+  }
+}
+
+// Expands chunks of current level until all of them are claimed.
+// Positions are counted in local counters, saved for the thread with
+// given id at the end, so that threads don't share cache lines while
+// counting.
+static void expand_claimed_positions(Search *search, size_t id,
+                                     Vector *next) {
+  Counters counters = {0};
+  size_t level_size = vector_size(search->current_depth_positions);
+  uint64_t *level = vector_data(search->current_depth_positions);
+
+  while (!__atomic_load_n(&search->end_reached, __ATOMIC_RELAXED)) {
+    size_t begin =
+        __atomic_fetch_add(&search->claimed, CHUNK, __ATOMIC_RELAXED);
+    if (begin >= level_size) {
+      break;
+    }
+
+    size_t n = level_size - begin < CHUNK ? level_size - begin : CHUNK;
+    if (expand_positions(search, &level[begin], n, next, &counters)) {
+      __atomic_store_n(&search->end_reached, true, __ATOMIC_RELAXED);
+    }
+  }
+
+  search->counters[id] = counters;
+}
+
+// Records level expanded by all threads and computes where positions
+// found by each thread will be copied.
+static void prepare_merge(Search *search) {
+  Counters counters = {0};
+  size_t next_level_size = 0;
+  for (size_t id = 0; id < search->threads; id++) {
+    counters.expanded += search->counters[id].expanded;
+    counters.neighbour_checks += search->counters[id].neighbour_checks;
+    search->offsets[id] = next_level_size;
+    next_level_size += vector_size(search->found_positions[id]);
+  }
+  record_level(search, &counters, next_level_size);
+
+  if (search->end_reached) {
+    search->answer = search->depth + 1;
+    search->finished = true;
+    return;
+  }
+
+  vector_resize(search->next_depth_positions, next_level_size);
+}
+
+// Makes next level the current one.
+static void finish_level(Search *search) {
+  swap((void **)&search->current_depth_positions,
+       (void **)&search->next_depth_positions);
+  ++search->depth;
+  search->claimed = 0;
+
+  expand_small_levels(search);
+}
+
+static void search_worker(void *search_ptr, size_t id) {
+  Search *search = (Search *)search_ptr;
+  Vector *found = search->found_positions[id];
+
+  while (true) {
+    expand_claimed_positions(search, id, found);
+
+    if (pthread_barrier_wait(&search->barrier) ==
+        PTHREAD_BARRIER_SERIAL_THREAD) {
+      prepare_merge(search);
+    }
+    pthread_barrier_wait(&search->barrier);
+    if (search->finished) {
+      return;
+    }
+
+    // copy found positions to next level
+    memcpy(vector_data(search->next_depth_positions) + search->offsets[id],
+           vector_data(found), vector_size(found) * sizeof(uint64_t));
+    vector_clear(found);
+
+    if (pthread_barrier_wait(&search->barrier) ==
+        PTHREAD_BARRIER_SERIAL_THREAD) {
+      finish_level(search);
+    }
+    pthread_barrier_wait(&search->barrier);
+    if (search->finished) {
+      return;
+    }
+  }
+}
+
+size_t parallel_find_shortest_path(Maze *maze) {
+  Search search = {0};
+  search.walls = maze_walls(maze);
+  search.visited = maze_visited(maze, maze_size(maze));
+  search.dimensions_number = maze_dimensions_number(maze);
+  search.end_position_hash = maze_end_position_hash(maze);
+  search.threads = parallel_threads();
+
+  search.dimensions =
+      (uint64_t *)safe_calloc(search.dimensions_number, sizeof(uint64_t));
+  for (size_t i = 0; i < search.dimensions_number; i++) {
+    search.dimensions[i] = maze_dimension(maze, i);
+  }
+
+  search.current_depth_positions = vector_create();
+  search.next_depth_positions = vector_create();
+  search.found_positions =
+      (Vector **)safe_calloc(search.threads, sizeof(Vector *));
+  search.offsets = (size_t *)safe_calloc(search.threads, sizeof(size_t));
+  search.counters =
+      (Counters *)safe_calloc(search.threads, sizeof(Counters));
+  for (size_t id = 0; id < search.threads; id++) {
+    search.found_positions[id] = vector_create();
+  }
+
+  // initialize bfs using start position
+  vector_push_back(search.current_depth_positions,
+                   maze_start_position_hash(maze));
+  bitset_set(search.visited, maze_start_position_hash(maze));
+
+  expand_small_levels(&search);
+  if (!search.finished) {
+    pthread_barrier_init(&search.barrier, NULL, (unsigned)search.threads);
+    parallel_run(search.threads, search_worker, &search);
+    pthread_barrier_destroy(&search.barrier);
+  }
+
+  for (size_t id = 0; id < search.threads; id++) {
+    vector_free(search.found_positions[id]);
+  }
+  free(search.found_positions);
+  free(search.offsets);
+  free(search.counters);
+  vector_free(search.current_depth_positions);
+  vector_free(search.next_depth_positions);
+  free(search.dimensions);
+
+  return search.answer;
+}
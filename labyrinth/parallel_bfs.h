@@ -0,0 +1,15 @@
+#ifndef PARALLEL_BFS_H
+#define PARALLEL_BFS_H
+
+#include <stddef.h>
+#include "maze.h"
+
+// Finds length of the shortest path from start to end position using
+// level-synchronous bfs, which splits every level between
+// parallel_threads() threads. Returns the same value as the serial
+// search, i.e. 0 if the path doesn't exist. Keeps visited positions
+// apart from walls in the visited bitset of maze. Assumes that start and
+// end positions are not equal.
+size_t parallel_find_shortest_path(Maze *maze);
+
+#endif  // PARALLEL_BFS_H
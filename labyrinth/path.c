@@ -0,0 +1,164 @@
+#include "path.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include "frontier.h"
+#include "grid_bfs.h"
+#include "utils.h"
+
+// Bits of a label of one position.
+#define LABEL_BITS 2
+
+// Label of a position which wasn't visited.
+#define UNVISITED 3
+
+// Labels of all maze positions, LABEL_BITS bits each. Label of a visited
+// position is its distance from end position modulo 3. Distances of
+// adjacent positions differ by at most 1, so a neighbour of a position
+// at distance d has distance d - 1 if and only if its label is
+// (d - 1) mod 3. Labels are stored increased by 1, so that positions
+// which weren't visited hold 0 and pages of the bitset are committed
+// only where positions are visited. Bits are kept in the visited bitset
+// of maze.
+typedef struct {
+  Bitset *bits;
+} Labels;
+
+static Labels labels_create(Maze *maze) {
+  Labels labels = {
+      maze_visited(maze, safe_product(maze_size(maze), LABEL_BITS))};
+  return labels;
+}
+
+static unsigned labels_get(Labels *labels, size_t i) {
+  uint64_t stored = bitset_read_bits(labels->bits, i * LABEL_BITS,
+                                     LABEL_BITS);
+  return (unsigned)(stored + UNVISITED) % (UNVISITED + 1);
+}
+
+// Sets label of a position which wasn't visited.
+static void labels_set(Labels *labels, size_t i, unsigned label) {
+  unsigned stored = label + 1;
+  for (size_t bit = 0; bit < LABEL_BITS; bit++) {
+    if (stored >> bit & 1) {
+      bitset_set(labels->bits, i * LABEL_BITS + bit);
+    }
+  }
+}
+
+// Labels positions with their distance from end position, until start
+// position is reached. Returns its distance or SIZE_MAX if it can't be
+// reached.
+static size_t label_positions(Maze *maze, Labels *labels,
+                              size_t *neighbours) {
+  size_t size = maze_size(maze);
+  Bitset *walls = maze_walls(maze);
+  size_t start_position_hash = maze_start_position_hash(maze);
+
+  Frontier *current_depth_positions, *next_depth_positions;
+  maze_frontiers(maze, size, &current_depth_positions, &next_depth_positions);
+
+  // initialize bfs using end position
+  frontier_push(current_depth_positions, maze_end_position_hash(maze));
+  labels_set(labels, maze_end_position_hash(maze), 0);
+
+  size_t answer = SIZE_MAX, depth = 0;
+  if (maze_end_position_hash(maze) == start_position_hash) {
+    answer = 0;
+  }
+
+  while (answer == SIZE_MAX && !frontier_is_empty(current_depth_positions)) {
+    size_t position_hash = frontier_pop(current_depth_positions);
+
+    size_t neighbours_number =
+        maze_neighbours(maze, position_hash, neighbours);
+    for (size_t j = 0; j < neighbours_number; j++) {
+      size_t next_position_hash = neighbours[j];
+      if (bitset_get(walls, next_position_hash) ||
+          labels_get(labels, next_position_hash) != UNVISITED) {
+        continue;
+      }
+
+      labels_set(labels, next_position_hash, (depth + 1) % 3);
+      if (next_position_hash == start_position_hash) {
+        answer = depth + 1;
+        break;
+      }
+
+      frontier_push(next_depth_positions, next_position_hash);
+    }
+
+    // check if all positions of current depth were visited
+    if (frontier_is_empty(current_depth_positions)) {
+      ++depth;
+      swap((void **)&current_depth_positions, (void **)&next_depth_positions);
+    }
+  }
+
+  return answer;
+}
+
+// Prints coordinates of position with given hash in one line.
+static void print_position(Maze *maze, size_t position_hash,
+                           Vector *position) {
+  maze_position(maze, position_hash, position);
+  for (size_t i = 0; i < vector_size(position); i++) {
+    printf(i == 0 ? "%" PRIu64 : " %" PRIu64, vector_get(position, i));
+  }
+  printf("\n");
+}
+
+// Prints path of one-dimensional maze, which exists if there are no walls
+// between start and end position.
+static void print_line_path(Maze *maze) {
+  size_t start = maze_start_position_hash(maze);
+  size_t end = maze_end_position_hash(maze);
+  size_t path_length = line_find_shortest_path(maze);
+  if (path_length == 0 && start != end) {
+    printf("NO WAY\n");
+    return;
+  }
+
+  printf("%zu\n", path_length);
+  Vector *position = vector_create();
+  for (size_t i = 0; i <= path_length; i++) {
+    print_position(maze, start < end ? start + i : start - i, position);
+  }
+  vector_free(position);
+}
+
+void path_print_shortest_path(Maze *maze) {
+  if (maze_dimensions_number(maze) == 1) {
+    print_line_path(maze);
+    return;
+  }
+
+  Labels labels = labels_create(maze);
+  size_t *neighbours = (size_t *)safe_calloc(
+      2 * maze_dimensions_number(maze), sizeof(size_t));
+
+  size_t path_length = label_positions(maze, &labels, neighbours);
+  if (path_length == SIZE_MAX) {
+    printf("NO WAY\n");
+  } else {
+    printf("%zu\n", path_length);
+
+    // walk from start to end position, every step decreasing distance
+    Vector *position = vector_create();
+    size_t position_hash = maze_start_position_hash(maze);
+    print_position(maze, position_hash, position);
+    for (size_t depth = path_length; depth > 0; depth--) {
+      size_t neighbours_number =
+          maze_neighbours(maze, position_hash, neighbours);
+      for (size_t j = 0; j < neighbours_number; j++) {
+        if (labels_get(&labels, neighbours[j]) == (depth - 1) % 3) {
+          position_hash = neighbours[j];
+          break;
+        }
+      }
+      print_position(maze, position_hash, position);
+    }
+    vector_free(position);
+  }
+
+  free(neighbours);
+}
@@ -0,0 +1,15 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include "maze.h"
+
+// Prints length of the shortest path from start to end position of maze
+// and coordinates of its positions, one position per line, or prints
+// NO WAY if it doesn't exist. Every visited position stores only its
+// distance from end position modulo 3 in 2 bits, which are committed
+// only for visited positions, so it works for periodic and compressed
+// walls too. One-dimensional mazes need no search. Doesn't modify maze
+// walls.
+void path_print_shortest_path(Maze *maze);
+
+#endif  // PATH_H
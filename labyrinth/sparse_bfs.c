@@ -0,0 +1,137 @@
+#include "sparse_bfs.h"
+#include <stdbool.h>
+#include "bitset.h"
+#include "stats.h"
+#include "utils.h"
+#include "vector.h"
+
+// Initial number of slots of a hash set.
+#define INITIAL_CAPACITY 1024
+
+// Set of position hashes with open addressing and linear probing. Slots
+// hold hash + 1, so that 0 marks an empty slot.
+typedef struct {
+  uint64_t *slots;
+  size_t capacity;
+  size_t elements_number;
+} HashSet;
+
+static void hash_set_init(HashSet *set, size_t capacity) {
+  set->slots = (uint64_t *)safe_calloc(capacity, sizeof(uint64_t));
+  set->capacity = capacity;
+  set->elements_number = 0;
+}
+
+// Returns slot where hash is stored or should be stored.
+static size_t find_slot(HashSet *set, uint64_t hash) {
+  // multiplicative hashing spreads neighbouring positions
+  size_t slot = (size_t)((hash * 0x9E3779B97F4A7C15ULL) >> 20) &
+                (set->capacity - 1);
+  while (set->slots[slot] != 0 && set->slots[slot] != hash + 1) {
+    slot = (slot + 1) & (set->capacity - 1);
+  }
+
+  return slot;
+}
+
+// Doubles capacity of set and moves all its elements.
+static void grow(HashSet *set) {
+  HashSet old = *set;
+  hash_set_init(set, 2 * old.capacity);
+  for (size_t i = 0; i < old.capacity; i++) {
+    if (old.slots[i] != 0) {
+      set->slots[find_slot(set, old.slots[i] - 1)] = old.slots[i];
+    }
+  }
+  set->elements_number = old.elements_number;
+
+  free(old.slots);
+}
+
+// Adds hash to set. Returns false if it was already there.
+static bool hash_set_insert(HashSet *set, uint64_t hash) {
+  size_t slot = find_slot(set, hash);
+  if (set->slots[slot] != 0) {
+    return false;
+  }
+
+  set->slots[slot] = hash + 1;
+
+  // keep load factor at most 1/2
+  if (2 * ++set->elements_number > set->capacity) {
+    grow(set);
+  }
+
+  return true;
+}
+
+// Records bfs level in statistics.
+static void record_level(HashSet *visited, Vector *next_depth_positions,
+                         size_t expanded, size_t neighbour_checks) {
+  stats_level(expanded, neighbour_checks,
+              (visited->capacity + vector_size(next_depth_positions)) *
+                  sizeof(uint64_t));
+}
+
+size_t sparse_find_shortest_path(Maze *maze) {
+  Bitset *walls = maze_walls(maze);
+  size_t end_position_hash = maze_end_position_hash(maze);
+  size_t answer = 0, depth = 0;
+
+  HashSet visited;
+  hash_set_init(&visited, INITIAL_CAPACITY);
+  size_t *neighbours = (size_t *)safe_calloc(
+      2 * maze_dimensions_number(maze), sizeof(size_t));
+
+  // will store hashes of positions
+  Vector *current_depth_positions = vector_create();
+  Vector *next_depth_positions = vector_create();
+
+  // initialize bfs using start position
+  vector_push_back(current_depth_positions, maze_start_position_hash(maze));
+  hash_set_insert(&visited, maze_start_position_hash(maze));
+
+  size_t expanded = 0, neighbour_checks = 0;
+  while (!answer && !vector_is_empty(current_depth_positions)) {
+    uint64_t position_hash = vector_pop_back(current_depth_positions);
+    ++expanded;
+
+    size_t neighbours_number =
+        maze_neighbours(maze, position_hash, neighbours);
+    for (size_t j = 0; j < neighbours_number; j++) {
+      size_t next_position_hash = neighbours[j];
+      ++neighbour_checks;
+      if (bitset_get(walls, next_position_hash) ||
+          !hash_set_insert(&visited, next_position_hash)) {
+        continue;
+      }
+
+      if (next_position_hash == end_position_hash) {
+        answer = depth + 1;
+        break;
+      }
+
+      vector_push_back(next_depth_positions, next_position_hash);
+    }
+
+    // check if all positions of current depth were visited
+    if (vector_is_empty(current_depth_positions)) {
+      record_level(&visited, next_depth_positions, expanded,
+                   neighbour_checks);
+      expanded = neighbour_checks = 0;
+      ++depth;
+      swap((void **)&current_depth_positions, (void **)&next_depth_positions);
+    }
+  }
+
+  if (expanded > 0) {
+    record_level(&visited, next_depth_positions, expanded, neighbour_checks);
+  }
+
+  vector_free(current_depth_positions);
+  vector_free(next_depth_positions);
+  free(visited.slots);
+  free(neighbours);
+
+  return answer;
+}
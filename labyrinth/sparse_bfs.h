@@ -0,0 +1,14 @@
+#ifndef SPARSE_BFS_H
+#define SPARSE_BFS_H
+
+#include <stddef.h>
+#include "maze.h"
+
+// Finds length of the shortest path from start to end position using bfs
+// which keeps visited positions in a hash set, so its memory depends only
+// on the number of visited positions. Walls are only read, so they may be
+// periodic. Returns 0 if the path doesn't exist. Assumes that start and
+// end positions are not equal.
+size_t sparse_find_shortest_path(Maze *maze);
+
+#endif  // SPARSE_BFS_H
@@ -0,0 +1,181 @@
+#define _GNU_SOURCE
+
+#include "stats.h"
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "vector.h"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// Hardware events counted while statistics are enabled.
+#define COUNTERS_NUMBER 3
+
+static const char *counter_names[COUNTERS_NUMBER] = {
+    "cycles",
+    "instructions",
+    "cache misses",
+};
+
+// Times when phases were started and their total times, in seconds.
+static double start_times[PHASES_NUMBER];
+static double total_times[PHASES_NUMBER];
+
+static const char *phase_names[PHASES_NUMBER] = {"parse", "walls", "search"};
+
+static bool enabled = false;
+
+// Fraction of walls or a negative number, if it's unknown.
+static double wall_density = -1;
+
+// Sizes of consecutive bfs levels.
+static Vector *level_sizes = NULL;
+static size_t neighbour_checks_number = 0;
+static size_t peak_bytes = 0;
+
+// File descriptors of hardware counters or -1, if they're unavailable.
+static int counters[COUNTERS_NUMBER] = {-1, -1, -1};
+
+// Returns time from an arbitrary fixed point in seconds.
+static double now() {
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+
+  return (double)time.tv_sec + (double)time.tv_nsec / 1e9;
+}
+
+// Opens hardware counters of this process. The first one leads a group,
+// so all of them count at the same time.
+static void open_counters() {
+#ifdef __linux__
+  static const uint64_t configs[COUNTERS_NUMBER] = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+  };
+
+  for (size_t i = 0; i < COUNTERS_NUMBER; i++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[i];
+    attr.disabled = i == 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+
+    counters[i] = (int)syscall(SYS_perf_event_open, &attr, 0, -1,
+                               i == 0 ? -1 : counters[0], 0);
+    if (counters[i] < 0) {
+      break;
+    }
+  }
+
+  if (counters[0] >= 0) {
+    ioctl(counters[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#endif
+}
+
+static void print_counters() {
+  bool available = false;
+  for (size_t i = 0; i < COUNTERS_NUMBER && counters[i] >= 0; i++) {
+    uint64_t value;
+    if (read(counters[i], &value, sizeof(value)) == sizeof(value)) {
+      fprintf(stderr, "%s: %" PRIu64 "\n", counter_names[i], value);
+      available = true;
+    }
+    close(counters[i]);
+  }
+
+  if (!available) {
+    fprintf(stderr, "hardware counters: unavailable\n");
+  }
+}
+
+void stats_enable() {
+  if (!enabled) {
+    enabled = true;
+    level_sizes = vector_create();
+    open_counters();
+  }
+}
+
+bool stats_enabled() {
+  return enabled;
+}
+
+void stats_start(Phase phase) {
+  start_times[phase] = now();
+}
+
+void stats_stop(Phase phase) {
+  total_times[phase] += now() - start_times[phase];
+}
+
+double stats_seconds(Phase phase) {
+  return total_times[phase];
+}
+
+void stats_set_wall_density(double density) {
+  wall_density = density;
+}
+
+void stats_level(size_t positions, size_t neighbour_checks, size_t bytes) {
+  if (!enabled) {
+    return;
+  }
+
+  vector_push_back(level_sizes, positions);
+  neighbour_checks_number += neighbour_checks;
+  if (bytes > peak_bytes) {
+    peak_bytes = bytes;
+  }
+}
+
+size_t stats_expanded_positions() {
+  size_t expanded = 0;
+  if (!enabled) {
+    return expanded;
+  }
+
+  for (size_t i = 0; i < vector_size(level_sizes); i++) {
+    expanded += vector_get(level_sizes, i);
+  }
+
+  return expanded;
+}
+
+void stats_print() {
+  for (size_t phase = 0; phase < PHASES_NUMBER; phase++) {
+    fprintf(stderr, "%s time: %.6f s\n", phase_names[phase],
+            total_times[phase]);
+  }
+
+  if (wall_density >= 0) {
+    fprintf(stderr, "wall density: %.6f\n", wall_density);
+  }
+
+  // levels are recorded only by bfs solver
+  if (!vector_is_empty(level_sizes)) {
+    size_t expanded = 0;
+    fprintf(stderr, "levels: %zu\nlevel sizes:", vector_size(level_sizes));
+    for (size_t i = 0; i < vector_size(level_sizes); i++) {
+      fprintf(stderr, " %" PRIu64, vector_get(level_sizes, i));
+      expanded += vector_get(level_sizes, i);
+    }
+    fprintf(stderr, "\nexpanded positions: %zu\n", expanded);
+    fprintf(stderr, "neighbour checks: %zu\n", neighbour_checks_number);
+    fprintf(stderr, "peak frontier bytes: %zu\n", peak_bytes);
+  }
+
+  print_counters();
+  vector_free(level_sizes);
+}
@@ -0,0 +1,49 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Phases of the program whose time is measured.
+typedef enum {
+  // reading dimensions and positions
+  PHASE_PARSE,
+  // reading and building walls
+  PHASE_WALLS,
+  // finding the shortest path
+  PHASE_SEARCH,
+  PHASES_NUMBER,
+} Phase;
+
+// Enables collecting statistics other than phase times and starts hardware
+// counters, if they're available. By default, it's disabled.
+void stats_enable();
+
+// Checks if statistics are collected.
+bool stats_enabled();
+
+// Starts measuring time of phase.
+void stats_start(Phase phase);
+
+// Stops measuring time of phase and adds it to the total time of phase.
+void stats_stop(Phase phase);
+
+// Returns total measured time of phase in seconds.
+double stats_seconds(Phase phase);
+
+// Saves fraction of maze positions which are walls.
+void stats_set_wall_density(double density);
+
+// Records a finished bfs level: given numbers of positions expanded and
+// neighbours checked, and bytes taken by search structures. Does nothing
+// if statistics aren't enabled.
+void stats_level(size_t positions, size_t neighbour_checks, size_t bytes);
+
+// Returns number of positions of all recorded bfs levels.
+size_t stats_expanded_positions();
+
+// Prints phase times and statistics collected since they were enabled to
+// standard error.
+void stats_print();
+
+#endif  // STATS_H
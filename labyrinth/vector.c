@@ -73,3 +73,19 @@ size_t vector_size(Vector *v) {
 bool vector_is_empty(Vector *v) {
   return v->elements_number == 0;
 }
+
+uint64_t *vector_data(Vector *v) {
+  return v->data;
+}
+
+void vector_resize(Vector *v, size_t n) {
+  if (n > v->size) {
+    while (v->size < n) {
+      v->size = safe_product(v->size, 2);
+    }
+    v->data = (uint64_t *)safe_realloc(
+        v->data, safe_product(v->size, sizeof(uint64_t)));
+  }
+
+  v->elements_number = n;
+}
@@ -35,4 +35,12 @@ size_t vector_size(Vector *v);
 // Checks if vector is empty.
 bool vector_is_empty(Vector *v);
 
+// Returns pointer to the first element of vector. It's invalidated by
+// any operation that adds elements.
+uint64_t *vector_data(Vector *v);
+
+// Changes number of elements of vector to n. New elements are
+// uninitialized.
+void vector_resize(Vector *v, size_t n);
+
 #endif  // VECTOR_H
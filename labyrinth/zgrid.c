@@ -0,0 +1,226 @@
+#include "zgrid.h"
+#include "frontier.h"
+#include "stats.h"
+#include "utils.h"
+
+// Grid is created only if it has at most MAX_GROWTH times more codes than
+// maze has positions.
+#define MAX_GROWTH 4
+
+// Codes have at most this many bits.
+#define CODE_BITS_MAX 63
+
+// Returns code with coordinate of mask increased by 1. Bits outside mask
+// are filled with ones, so that the carry passes through them.
+static inline uint64_t increment(uint64_t code, uint64_t mask) {
+  return (((code | ~mask) + 1) & mask) | (code & ~mask);
+}
+
+// Returns code with coordinate of mask decreased by 1. Bits outside mask
+// are cleared, so that the borrow passes through them.
+static inline uint64_t decrement(uint64_t code, uint64_t mask) {
+  return (((code & mask) - 1) & mask) | (code & ~mask);
+}
+
+// Spreads bits of value over bits of mask, from the least significant.
+static uint64_t deposit(uint64_t value, uint64_t mask) {
+  uint64_t code = 0;
+  for (uint64_t bit = 1; mask != 0 && value != 0; bit <<= 1) {
+    if (mask & bit) {
+      code |= (value & 1) * bit;
+      value >>= 1;
+      mask &= ~bit;
+    }
+  }
+
+  return code;
+}
+
+// Returns number of bits needed to store numbers smaller than n.
+static size_t bits_number(uint64_t n) {
+  size_t bits = 0;
+  while (bits < 64 && (1ULL << bits) < n) {
+    ++bits;
+  }
+
+  return bits;
+}
+
+// Assigns bits of codes to dimensions in turns, from the least
+// significant. Returns number of used bits or a number larger than
+// CODE_BITS_MAX if they don't fit.
+static size_t assign_bits(ZGrid *grid, Maze *maze) {
+  size_t k = grid->dimensions_number, used_bits = 0;
+  size_t *dimension_bits = (size_t *)safe_calloc(k, sizeof(size_t));
+  size_t max_bits = 0;
+  for (size_t i = 0; i < k; i++) {
+    // border adds 2 to every dimension
+    dimension_bits[i] = bits_number(safe_sum(maze_dimension(maze, i), 2));
+    max_bits = dimension_bits[i] > max_bits ? dimension_bits[i] : max_bits;
+  }
+
+  for (size_t round = 0; round < max_bits; round++) {
+    for (size_t i = 0; i < k; i++) {
+      if (round < dimension_bits[i]) {
+        if (used_bits < CODE_BITS_MAX) {
+          grid->masks[i] |= 1ULL << used_bits;
+        }
+        ++used_bits;
+      }
+    }
+  }
+
+  free(dimension_bits);
+
+  return used_bits;
+}
+
+// Returns code of maze position with given hash.
+static size_t position_code(ZGrid *grid, Maze *maze, size_t position_hash) {
+  size_t code = 0;
+  for (size_t i = 0; i < grid->dimensions_number; i++) {
+    uint64_t n_i = maze_dimension(maze, i);
+    code |= deposit(position_hash % n_i + 1, grid->masks[i]);
+    position_hash /= n_i;
+  }
+
+  return code;
+}
+
+// Copies maze walls into the grid, visiting maze positions in row-major
+// order and updating their code coordinate by coordinate.
+static void copy_walls(ZGrid *grid, Maze *maze) {
+  size_t k = grid->dimensions_number;
+  uint64_t *coordinates = (uint64_t *)safe_calloc(k, sizeof(uint64_t));
+  uint64_t *dimensions = (uint64_t *)safe_calloc(k, sizeof(uint64_t));
+  for (size_t i = 0; i < k; i++) {
+    dimensions[i] = maze_dimension(maze, i);
+  }
+
+  // the first position is 1 in every coordinate, after the border
+  uint64_t first_code = 0;
+  for (size_t i = 0; i < k; i++) {
+    first_code |= deposit(1, grid->masks[i]);
+  }
+
+  Bitset *walls = maze_walls(maze);
+  size_t size = maze_size(maze);
+  uint64_t code = first_code;
+  for (size_t hash = 0; hash < size; hash++) {
+    if (!bitset_get(walls, hash)) {
+      bitset_unset(grid->walls, code);
+    }
+
+    // move to the next position
+    for (size_t i = 0; i < k; i++) {
+      if (++coordinates[i] < dimensions[i]) {
+        code = increment(code, grid->masks[i]);
+        break;
+      }
+
+      coordinates[i] = 0;
+      code = (code & ~grid->masks[i]) | (first_code & grid->masks[i]);
+    }
+  }
+
+  free(coordinates);
+  free(dimensions);
+}
+
+ZGrid *zgrid_create(Maze *maze) {
+  ZGrid *grid = (ZGrid *)safe_malloc(sizeof(ZGrid));
+  grid->dimensions_number = maze_dimensions_number(maze);
+  grid->masks =
+      (uint64_t *)safe_calloc(grid->dimensions_number, sizeof(uint64_t));
+  grid->walls = NULL;
+
+  size_t used_bits = assign_bits(grid, maze);
+  if (used_bits > CODE_BITS_MAX ||
+      (1ULL << used_bits) / MAX_GROWTH > maze_size(maze) ||
+      bitset_is_periodic(maze_walls(maze))) {
+    zgrid_free(grid);
+    return NULL;
+  }
+  grid->size = 1ULL << used_bits;
+
+  // every code is a wall until maze walls are copied
+  grid->walls = maze_visited(maze, grid->size);
+  bitset_fill(grid->walls);
+  copy_walls(grid, maze);
+
+  grid->start_position_hash =
+      position_code(grid, maze, maze_start_position_hash(maze));
+  grid->end_position_hash =
+      position_code(grid, maze, maze_end_position_hash(maze));
+
+  return grid;
+}
+
+void zgrid_free(ZGrid *grid) {
+  if (grid != NULL) {
+    free(grid->masks);
+    free(grid);
+  }
+}
+
+// Records bfs level, which expanded given number of positions and checked
+// given number of their neighbours, in statistics.
+static void record_level(size_t expanded, size_t neighbour_checks,
+                         Frontier *current, Frontier *next) {
+  stats_level(expanded, neighbour_checks,
+              frontier_bytes(current) + frontier_bytes(next));
+}
+
+size_t zgrid_find_shortest_path(Maze *maze, ZGrid *grid) {
+  size_t answer = 0, depth = 0;
+  size_t k = grid->dimensions_number;
+
+  // will store codes of positions
+  Frontier *current_depth_positions, *next_depth_positions;
+  maze_frontiers(maze, grid->size, &current_depth_positions,
+                 &next_depth_positions);
+
+  // initialize bfs using start position
+  frontier_push(current_depth_positions, grid->start_position_hash);
+  bitset_set(grid->walls, grid->start_position_hash);
+
+  size_t expanded = 0, neighbour_checks = 0;
+  while (!answer && !frontier_is_empty(current_depth_positions)) {
+    uint64_t code = frontier_pop(current_depth_positions);
+    ++expanded;
+
+    for (size_t j = 0; j < 2 * k; j++) {
+      // border walls make both directions always valid
+      size_t next_code = j % 2 == 0 ? decrement(code, grid->masks[j / 2])
+                                    : increment(code, grid->masks[j / 2]);
+      ++neighbour_checks;
+      if (bitset_get(grid->walls, next_code)) {
+        continue;
+      }
+
+      if (next_code == grid->end_position_hash) {
+        answer = depth + 1;
+        break;
+      }
+
+      frontier_push(next_depth_positions, next_code);
+      bitset_set(grid->walls, next_code);
+    }
+
+    // check if all positions of current depth were visited
+    if (frontier_is_empty(current_depth_positions)) {
+      record_level(expanded, neighbour_checks, current_depth_positions,
+                   next_depth_positions);
+      expanded = neighbour_checks = 0;
+      ++depth;
+      swap((void **)&current_depth_positions, (void **)&next_depth_positions);
+    }
+  }
+
+  if (expanded > 0) {
+    record_level(expanded, neighbour_checks, current_depth_positions,
+                 next_depth_positions);
+  }
+
+  return answer;
+}
@@ -0,0 +1,38 @@
+#ifndef ZGRID_H
+#define ZGRID_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bitset.h"
+#include "maze.h"
+
+// Maze surrounded by a border of walls, whose positions are stored in
+// Z-order: bits of all coordinates are interleaved, so positions close in
+// every dimension are close in memory. Coordinate i is stored in the bits
+// of masks[i] and a neighbour is found by adding or subtracting 1 only
+// in these bits.
+typedef struct {
+  size_t dimensions_number;
+  uint64_t *masks;
+  // number of codes, i.e. 2 to the power of the number of used bits
+  size_t size;
+  Bitset *walls;
+  size_t start_position_hash;
+  size_t end_position_hash;
+} ZGrid;
+
+// Creates Z-order grid from maze walls. Maze walls aren't modified, grid
+// walls are kept in the visited bitset of maze (see maze_visited).
+// Returns NULL if codes would be much more numerous than maze positions.
+ZGrid *zgrid_create(Maze *maze);
+
+// Frees all allocated memory of passed grid.
+void zgrid_free(ZGrid *grid);
+
+// Finds length of the shortest path from start to end position of grid
+// created from maze using bfs and returns it. If it doesn't exist,
+// returns 0. Marks visited positions as grid walls and keeps frontiers in
+// maze storage. Assumes that start and end positions are not equal.
+size_t zgrid_find_shortest_path(Maze *maze, ZGrid *grid);
+
+#endif  // ZGRID_H